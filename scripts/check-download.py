@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Copyright (C) 2021 Guyutongxue
+#
+# This file is part of VS Code Config Helper.
+#
+# VS Code Config Helper is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# VS Code Config Helper is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+# Check `vscch3 fetch` (the HTTP client used for update checks and analytics) against a local
+# server which redirects, fails with 5xx and cuts bodies short.
+#
+# Usage: scripts/check-download.py <path to vscch3>
+
+import collections
+import http.server
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import threading
+
+BODY = random.Random(42).randbytes(3 << 20)
+hits = collections.Counter()
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def send_body(self, status, body, length=None):
+        self.send_response(status)
+        self.send_header("Content-Length", str(len(body) if length is None else length))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        hits[self.path] += 1
+        if self.path == "/file":
+            self.send_body(200, BODY)
+        elif self.path == "/redirect":
+            self.send_response(302)
+            self.send_header("Location", "/file")
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+        elif self.path == "/flaky":
+            # Fails twice, then succeeds (within the 3 attempts)
+            if hits[self.path] <= 2:
+                self.send_body(503, b"busy")
+            else:
+                self.send_body(200, BODY)
+        elif self.path == "/broken":
+            self.send_body(500, b"error")
+        elif self.path == "/truncated":
+            # Announce the whole body but close after half of it
+            self.send_body(200, BODY[: len(BODY) // 2], len(BODY))
+            self.close_connection = True
+        else:
+            self.send_body(404, b"not found")
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"usage: {sys.argv[0]} <path to vscch3>")
+        return 2
+    exe = sys.argv[1]
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    base = f"http://127.0.0.1:{server.server_address[1]}"
+    failures = 0
+
+    def check(name, ok):
+        nonlocal failures
+        print(("PASS " if ok else "FAIL ") + name)
+        failures += not ok
+
+    with tempfile.TemporaryDirectory() as tmp:
+        def fetch(path, output):
+            return subprocess.run([exe, "fetch", base + path, "-o", output],
+                                  stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                                  timeout=60).returncode
+
+        def content(path):
+            with open(path, "rb") as f:
+                return f.read()
+
+        out = os.path.join(tmp, "file")
+        check("download", fetch("/file", out) == 0 and content(out) == BODY)
+
+        out = os.path.join(tmp, "redirect")
+        check("redirect is followed", fetch("/redirect", out) == 0 and content(out) == BODY)
+
+        out = os.path.join(tmp, "flaky")
+        check("5xx is retried", fetch("/flaky", out) == 0 and content(out) == BODY
+              and hits["/flaky"] == 3)
+
+        out = os.path.join(tmp, "broken")
+        check("persistent 5xx gives up after 3 attempts",
+              fetch("/broken", out) != 0 and hits["/broken"] == 3 and not os.path.exists(out))
+
+        out = os.path.join(tmp, "missing")
+        check("404 is not retried",
+              fetch("/missing", out) != 0 and hits["/missing"] == 1 and not os.path.exists(out))
+
+        # An existing file must survive a failed download
+        out = os.path.join(tmp, "truncated")
+        with open(out, "wb") as f:
+            f.write(b"old")
+        check("truncated body is not renamed into place",
+              fetch("/truncated", out) != 0 and content(out) == b"old"
+              and not os.path.exists(out + ".part"))
+
+    server.shutdown()
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
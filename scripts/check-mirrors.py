@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+# Copyright (C) 2021 Guyutongxue
+#
+# This file is part of VS Code Config Helper.
+#
+# VS Code Config Helper is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# VS Code Config Helper is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+# Check `vscch3 download` against several local, throttled mirrors: racing, parallel ranges,
+# resuming after an interruption, and restarting when the file is republished with the same size.
+#
+# Usage: scripts/check-mirrors.py <path to vscch3>
+
+import hashlib
+import http.server
+import os
+import random
+import re
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SIZE = 8 << 20
+BLOCK = 64 << 10
+
+
+class Mirror:
+    def __init__(self, speed):
+        # Bytes per second
+        self.speed = speed
+        self.publish(random.Random(1).randbytes(SIZE), '"v1"')
+        # Range requests answered with 503 after this many (None: never)
+        self.fail_after = None
+        self.ranges = 0
+        mirror = self
+
+        class Handler(http.server.BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def log_message(self, *args):
+                pass
+
+            def do_GET(self):
+                mirror.serve(self)
+
+        self.server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+        threading.Thread(target=self.server.serve_forever, daemon=True).start()
+        self.url = f"http://127.0.0.1:{self.server.server_address[1]}/toolchain.7z"
+
+    def publish(self, body, etag):
+        self.body = body
+        self.etag = etag
+
+    def serve(self, req):
+        body, etag = self.body, self.etag
+        match = re.fullmatch(r"bytes=(\d+)-(\d+)", req.headers.get("Range", ""))
+        if_range = req.headers.get("If-Range")
+        if match and (if_range is None or if_range == etag):
+            self.ranges += 1
+            if self.fail_after is not None and self.ranges > self.fail_after:
+                req.send_response(503)
+                req.send_header("Content-Length", "0")
+                req.end_headers()
+                return
+            begin, end = int(match[1]), min(int(match[2]), len(body) - 1)
+            req.send_response(206)
+            req.send_header("Content-Range", f"bytes {begin}-{end}/{len(body)}")
+            part = body[begin:end + 1]
+        else:
+            req.send_response(200)
+            part = body
+        req.send_header("ETag", etag)
+        req.send_header("Content-Length", str(len(part)))
+        req.end_headers()
+        try:
+            for i in range(0, len(part), BLOCK):
+                req.wfile.write(part[i:i + BLOCK])
+                time.sleep(BLOCK / self.speed)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+
+
+def unused_url():
+    with socket.socket() as s:
+        s.bind(("127.0.0.1", 0))
+        return f"http://127.0.0.1:{s.getsockname()[1]}/toolchain.7z"
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"usage: {sys.argv[0]} <path to vscch3>")
+        return 2
+    exe = sys.argv[1]
+    failures = 0
+
+    def check(name, ok):
+        nonlocal failures
+        print(("PASS " if ok else "FAIL ") + name)
+        failures += not ok
+
+    def download(urls, output, *args):
+        return subprocess.run([exe, "download", *urls, "-o", output, "-j", "4",
+                               "--chunk-size", "1", *args],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                              timeout=120).returncode
+
+    def content(path):
+        with open(path, "rb") as f:
+            return f.read()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        fast, slow = Mirror(32 << 20), Mirror(2 << 20)
+        sha256 = hashlib.sha256(fast.body).hexdigest()
+        out = os.path.join(tmp, "race")
+        ok = download([slow.url, unused_url(), fast.url], out, "--sha256", sha256) == 0
+        check("race: unreachable mirror skipped, file intact", ok and content(out) == fast.body)
+        check("race: the fast mirror serves most chunks", fast.ranges > slow.ranges)
+
+        mirror = Mirror(32 << 20)
+        mirror.fail_after = 3
+        out = os.path.join(tmp, "resume")
+        interrupted = download([mirror.url], out) != 0
+        check("resume: interrupted download fails and keeps its state",
+              interrupted and os.path.exists(out + ".part")
+              and os.path.exists(out + ".state.json"))
+        mirror.fail_after = None
+        mirror.ranges = 0
+        ok = download([mirror.url], out, "--sha256", hashlib.sha256(mirror.body).hexdigest()) == 0
+        # The probe, plus the chunks not done before
+        check("resume: only the missing chunks are fetched",
+              ok and content(out) == mirror.body and mirror.ranges < SIZE // (1 << 20) + 1)
+
+        mirror = Mirror(32 << 20)
+        mirror.fail_after = 3
+        out = os.path.join(tmp, "republish")
+        download([mirror.url], out)
+        mirror.fail_after = None
+        mirror.publish(random.Random(2).randbytes(SIZE), '"v2"')
+        ok = download([mirror.url], out) == 0
+        check("republish: same size, new ETag starts over", ok and content(out) == mirror.body)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
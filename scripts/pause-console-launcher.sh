@@ -2,7 +2,7 @@
 ###
 # Generate by VS Code Config Helper 3. Edit it only if you know what you are doing!
 
-# This script launches pause-console.rb with provided args.
+# This script launches `vscch run` with provided args.
 # In macOS, the default terminal `Terminal.app` do not accept arguments.
 # But, we can use AppleScript to pass arguments to it.
 # Here we compose an AppleScript, then execute it with `oscascript`.
@@ -25,6 +25,6 @@ cwd=${cwd//\"/\\\"}
 osascript > /dev/null <<EOF
 tell application "Terminal"
     activate
-    do script "cd ${cwd}; clear; ./pause-console.rb ${escaped_args[@]}; exit"
+    do script "cd ${cwd}; clear; ./vscch run ${escaped_args[@]}; exit"
 end tell
 EOF
\ No newline at end of file
@@ -0,0 +1,443 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bench.h"
+
+#include "native.h"
+
+#ifndef WINDOWS
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef LINUX
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#endif
+
+#include <iostream>
+
+#include "log.h"
+
+namespace Bench {
+
+#ifdef WINDOWS
+
+int benchCommand(int, char**) {
+    LOG_ERR("基准测试功能暂不支持 Windows。");
+    return 1;
+}
+
+int spawnBenchCommand(int, char**) {
+    LOG_ERR("基准测试功能暂不支持 Windows。");
+    return 1;
+}
+
+#else
+
+namespace po = boost::program_options;
+
+namespace {
+
+struct Counter {
+    const char* name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+#ifdef LINUX
+const std::array<Counter, 4> COUNTERS{{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+}};
+#else
+const std::array<Counter, 0> COUNTERS{};
+#endif
+
+using CounterValues = std::array<std::uint64_t, COUNTERS.size()>;
+
+struct RunResult {
+    double wallMs;
+    int status;
+    std::optional<CounterValues> counters;
+};
+
+#ifdef LINUX
+// Counters of the child process (and its children), enabled when it calls exec
+std::optional<std::array<int, COUNTERS.size()>> openCounters(pid_t pid) {
+    std::array<int, COUNTERS.size()> fds;
+    for (std::size_t i{0}; i < COUNTERS.size(); i++) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = COUNTERS[i].type;
+        attr.config = COUNTERS[i].config;
+        attr.disabled = 1;
+        attr.enable_on_exec = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds[i] = syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fds[i] < 0) {
+            for (std::size_t j{0}; j < i; j++) close(fds[j]);
+            return std::nullopt;
+        }
+    }
+    return fds;
+}
+#endif
+
+std::optional<RunResult> runOnce(const std::vector<char*>& argv, const std::string& input, int cpu,
+                                 bool& useCounters) {
+    // The child waits until counters are attached to it
+    int syncPipe[2];
+    if (pipe(syncPipe) < 0) return std::nullopt;
+    auto pid{fork()};
+    if (pid < 0) {
+        close(syncPipe[0]);
+        close(syncPipe[1]);
+        return std::nullopt;
+    }
+    if (pid == 0) {
+        close(syncPipe[1]);
+#ifdef LINUX
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+#endif
+        int inFd{open(input.empty() ? "/dev/null" : input.c_str(), O_RDONLY)};
+        int nullFd{open("/dev/null", O_WRONLY)};
+        if (inFd < 0 || nullFd < 0) _exit(127);
+        dup2(inFd, STDIN_FILENO);
+        dup2(nullFd, STDOUT_FILENO);
+        char c;
+        [[maybe_unused]] auto _{read(syncPipe[0], &c, 1)};
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    close(syncPipe[0]);
+    std::optional<CounterValues> counters;
+#ifdef LINUX
+    std::optional<std::array<int, COUNTERS.size()>> fds;
+    if (useCounters) {
+        fds = openCounters(pid);
+        if (!fds) {
+            if (errno == EACCES || errno == EPERM) {
+                LOG_WRN("没有使用 perf_event_open 的权限，将不收集硬件计数器。可调整 "
+                        "/proc/sys/kernel/perf_event_paranoid。");
+            } else {
+                LOG_WRN("无法使用 perf_event_open（", std::strerror(errno),
+                        "），将不收集硬件计数器。");
+            }
+            useCounters = false;
+        }
+    }
+#endif
+    auto start{std::chrono::steady_clock::now()};
+    [[maybe_unused]] auto _{write(syncPipe[1], "", 1)};
+    close(syncPipe[1]);
+    int status{0};
+    rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    auto elapsed{std::chrono::steady_clock::now() - start};
+#ifdef LINUX
+    if (fds) {
+        counters.emplace();
+        for (std::size_t i{0}; i < COUNTERS.size(); i++) {
+            if (read((*fds)[i], &(*counters)[i], sizeof(std::uint64_t)) != sizeof(std::uint64_t)) {
+                (*counters)[i] = 0;
+            }
+            close((*fds)[i]);
+        }
+    }
+#endif
+    return RunResult{std::chrono::duration<double, std::milli>(elapsed).count(), status, counters};
+}
+
+// Two-sided 95% quantiles of Student's t-distribution, indexed by degrees of freedom
+double tQuantile95(std::size_t df) {
+    static const double TABLE[]{0,     12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365,
+                                2.306, 2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+                                2.120, 2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069,
+                                2.064, 2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+    return df < std::size(TABLE) ? TABLE[df] : 1.960;
+}
+
+// Nearest-rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+    auto rank{static_cast<std::size_t>(std::ceil(p / 100 * sorted.size()))};
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+struct Samples {
+    std::vector<double> times;
+    std::vector<CounterValues> counters;
+};
+
+// Prints the statistics, and returns the median time
+double report(Samples& samples) {
+    auto& times{samples.times};
+    auto n{times.size()};
+    auto mean{std::accumulate(times.begin(), times.end(), 0.0) / n};
+    double variance{0};
+    for (auto t : times) {
+        variance += (t - mean) * (t - mean);
+    }
+    variance = n > 1 ? variance / (n - 1) : 0;
+    auto halfWidth{n > 1 ? tQuantile95(n - 1) * std::sqrt(variance / n) : 0};
+    std::sort(times.begin(), times.end());
+    auto median{percentile(times, 50)};
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  最短 " << times.front() << " ms，中位数 " << median << " ms，P95 "
+              << percentile(times, 95) << " ms" << std::endl;
+    std::cout << "  平均 " << mean << " ms ± " << halfWidth << " ms（95% 置信区间）" << std::endl;
+    if (!samples.counters.empty()) {
+        std::cout << "  硬件计数器（每次运行平均）：" << std::endl;
+        std::array<double, COUNTERS.size()> avg{};
+        for (const auto& values : samples.counters) {
+            for (std::size_t i{0}; i < COUNTERS.size(); i++) {
+                avg[i] += static_cast<double>(values[i]) / samples.counters.size();
+            }
+        }
+        std::cout << std::setprecision(0);
+        for (std::size_t i{0}; i < COUNTERS.size(); i++) {
+            std::cout << "    " << std::left << std::setw(14) << COUNTERS[i].name << std::right
+                      << std::setw(16) << avg[i] << std::endl;
+        }
+        // cycles and instructions
+        if (avg[0] > 0) {
+            std::cout << "    IPC " << std::setprecision(2) << avg[1] / avg[0] << std::endl;
+        }
+    }
+    return median;
+}
+
+}  // namespace
+
+int benchCommand(int argc, char** argv) {
+    std::string program, baseline, input;
+    std::vector<std::string> programArgs;
+    int runs, warmup, cpu;
+    // clang-format off
+    po::options_description desc("bench Options", 79);
+    desc.add_options()
+        ("program", po::value(&program), "要测试的程序")
+        ("args", po::value(&programArgs), "传给程序的参数（写在  --  之后）")
+        ("runs,n", po::value(&runs)->default_value(10), "计时的运行次数")
+        ("warmup,w", po::value(&warmup)->default_value(2), "预热的运行次数，不计入结果")
+        ("input,i", po::value(&input), "作为标准输入的文件")
+        ("cpu,c", po::value(&cpu)->default_value(-1), "固定在编号为 N 的 CPU 上运行，默认为当前 CPU")
+        ("baseline,b", po::value(&baseline), "与之比较的基准程序，将交替运行并报告加速比")
+        ("no-counters", "不收集硬件性能计数器")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("program", 1).add("args", -1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || program.empty() || runs < 1) {
+        std::cout << "用法：vscch3 bench <program> [options] [-- <args...>]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+#ifdef LINUX
+    if (cpu < 0) {
+        cpu = sched_getcpu();
+    }
+#else
+    if (cpu >= 0) {
+        LOG_WRN("当前系统不支持固定 CPU。");
+    }
+    cpu = -1;
+#endif
+    bool useCounters{!vm.count("no-counters") && !COUNTERS.empty()};
+
+    std::vector<std::string> programs{program};
+    if (!baseline.empty()) {
+        programs.push_back(baseline);
+    }
+    std::vector<std::vector<char*>> childArgvs;
+    for (auto& p : programs) {
+        std::vector<char*> childArgv{p.data()};
+        for (auto& arg : programArgs) {
+            childArgv.push_back(arg.data());
+        }
+        childArgv.push_back(nullptr);
+        childArgvs.push_back(std::move(childArgv));
+    }
+
+    // Alternate between the programs so that drifts (e.g. CPU frequency) affect both
+    std::vector<Samples> samples(programs.size());
+    for (int i{0}; i < warmup + runs; i++) {
+        for (std::size_t j{0}; j < programs.size(); j++) {
+            auto result{runOnce(childArgvs[j], input, cpu, useCounters)};
+            if (!result) {
+                LOG_ERR("无法创建进程：", std::strerror(errno));
+                return 1;
+            }
+            if (!WIFEXITED(result->status) || WEXITSTATUS(result->status) != 0) {
+                LOG_ERR("程序 ", programs[j], " 第 ", i + 1, " 次运行未正常退出（状态 ",
+                        result->status, "）。");
+                return 1;
+            }
+            if (i < warmup) continue;
+            samples[j].times.push_back(result->wallMs);
+            if (result->counters) {
+                samples[j].counters.push_back(*result->counters);
+            }
+        }
+    }
+
+    std::cout << "运行 " << runs << " 次（预热 " << warmup << " 次）";
+    if (cpu >= 0) {
+        std::cout << "，固定在 CPU " << cpu;
+    }
+    std::cout << "：" << std::endl;
+    std::vector<double> medians;
+    for (std::size_t j{0}; j < programs.size(); j++) {
+        if (programs.size() > 1) {
+            std::cout << (j == 0 ? "程序 " : "基准 ") << programs[j] << std::endl;
+        }
+        medians.push_back(report(samples[j]));
+    }
+    if (medians.size() > 1 && medians[0] > 0) {
+        std::cout << "加速比（按中位数）：" << std::setprecision(3) << medians[1] / medians[0]
+                  << "x" << std::endl;
+    }
+    return 0;
+}
+
+namespace {
+
+// Times one way of running a program, in microseconds
+template <typename F>
+double timeUs(const F& run) {
+    auto start{std::chrono::steady_clock::now()};
+    run();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+}  // namespace
+
+int spawnBenchCommand(int argc, char** argv) {
+    std::string program;
+    std::vector<std::size_t> sizes;
+    int runs;
+    // clang-format off
+    po::options_description desc("spawn-bench Options", 79);
+    desc.add_options()
+        ("program", po::value(&program)->default_value("true"), "被启动的程序")
+        ("rss,m", po::value(&sizes)->multitoken()->default_value({0, 256, 1024}, "0 256 1024"), "父进程额外占用的内存（MiB），可指定多个")
+        ("runs,n", po::value(&runs)->default_value(200), "每种方式的运行次数")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("program", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || runs < 1) {
+        std::cout << "用法：vscch3 spawn-bench [<program>] [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    namespace bp = boost::process;
+    auto exe{bp::search_path(program)};
+    if (exe.empty()) {
+        LOG_ERR("未找到程序 ", program, "。");
+        return 1;
+    }
+
+    // Both capture stdout through a pipe, as the callers do
+    auto runNative{[&] { return Native::spawn({.Args = {exe.string()}}).has_value(); }};
+    auto runBoost{[&] {
+        bp::ipstream is;
+        bp::child proc(exe, bp::std_out > is);
+        std::string output{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+        proc.wait();
+        return true;
+    }};
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "启动 " << program << " 各 " << runs << " 次，平均用时（μs）：" << std::endl;
+    std::cout << std::setw(10) << "RSS (MiB)" << std::setw(16) << "Native::spawn"
+              << std::setw(16) << "Boost.Process" << std::setw(10) << "加速比" << std::endl;
+    for (auto size : sizes) {
+        // Touch every page, so that they are really mapped and fork has to copy the page tables
+        std::vector<char> ballast;
+        try {
+            ballast.resize(size << 20, 1);
+        } catch (const std::bad_alloc&) {
+            LOG_ERR("无法分配 ", size, " MiB 内存。");
+            return 1;
+        }
+        double total[2]{};
+        for (int i{0}; i < runs; i++) {
+            // Alternate so that drifts affect both
+            total[0] += timeUs(runNative);
+            total[1] += timeUs(runBoost);
+        }
+        std::cout << std::setw(10) << size << std::setw(16) << total[0] / runs << std::setw(16)
+                  << total[1] / runs << std::setw(9) << std::setprecision(2)
+                  << total[1] / total[0] << "x" << std::setprecision(1) << std::endl;
+    }
+    return 0;
+}
+
+#endif
+
+}  // namespace Bench
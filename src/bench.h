@@ -0,0 +1,30 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Repeatedly run a program and report timing statistics and hardware counters
+
+#pragma once
+
+namespace Bench {
+
+// Subcommand `bench`
+int benchCommand(int argc, char** argv);
+
+// Subcommand `spawn-bench`: cost of Native::spawn vs. Boost.Process as the parent grows
+int spawnBenchCommand(int argc, char** argv);
+
+}  // namespace Bench
@@ -22,10 +22,24 @@
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
 
+#include "bench.h"
 #include "config.h"
+#include "cpu.h"
+#include "debugger.h"
+#include "downloader.h"
+#include "http_client.h"
+#include "installer.h"
+#include "judge.h"
+#include "launcher.h"
 #include "log.h"
 #include "native.h"
+#include "profile.h"
+#include "runner.h"
+#include "scan.h"
+#include "workspace.h"
 
 #ifndef WINDOWS
 #include <boost/process.hpp>
@@ -50,11 +64,12 @@ void preprocessOptions(const po::options_description& desc) {
     }
     if (options.Version) {
         std::cout << "VSCodeConfigHelper v" PROJECT_VERSION " (c) Guyutongxue" << std::endl;
+        std::cout << "CPU: " << Cpu::describe() << std::endl;
         std::exit(0);
     }
     if (options.CheckUpdate) {
         checkUpdate();
-        std::exit(0);
+        HttpClient::exit(0);
     }
 #ifdef MACOS
     if (!options.NoInstallClt) {
@@ -63,7 +78,8 @@ void preprocessOptions(const po::options_description& desc) {
                 "未安装 Xcode Command Line "
                 "Tools，将进行安装。这可能需要一段时间，请按照系统提示操作。安装完成后，再次启动本"
                 "工具以进行配置。");
-            boost::process::system("xcode-select --install");
+            Native::spawn({.Args = {"xcode-select", "--install"},
+                           .Stdout = Native::SpawnOptions::Stream::Inherit});
             std::exit(1);
         } else {
             LOG_INF("检测到已安装的 Xcode Command Line Tools。");
@@ -199,6 +215,35 @@ void init(int argc, char** argv) {
     ADD_OPTION_C("offline-cpptools", OfflineInstallCCpp, "此选项无作用，已弃用");
     ADD_OPTION_C("uninstall-extensions", ShouldUninstallExtensions, "卸载多余的 VS Code 扩展");
     ADD_OPTION_C("compile-arg,a", CompileArgs, "指定编译选项");
+    ADD_OPTION_C("pch", UsePch, "使用预编译头文件加速单文件编译");
+    ADD_OPTION_C("import-std", UseImportStd,
+                 "若编译器支持，使用 C++ 标准库模块（import std）加速编译，否则使用预编译头文件");
+    ADD_OPTION_C("compiler-launcher", CompilerLauncher,
+                 "指定编译缓存工具。可为 auto、ccache、sccache 或 none（默认）");
+    ADD_OPTION_C("launcher-cache-dir", LauncherCacheDir, "指定编译缓存文件夹，可为多个用户共享");
+    ADD_OPTION_C("launcher-cache-size", LauncherCacheSize, "指定编译缓存的大小上限，如 5G");
+    ADD_OPTION_C("project-build", ProjectBuild, "额外生成构建整个工作区的任务。可为 make 或 ninja");
+    ADD_OPTION_C("unity-build", UnityBuild, "额外生成将所有源文件合并编译的任务（unity  build）");
+    ADD_OPTION_C("compile-commands", GenerateCompileCommands,
+                 "为工作区生成 compile_commands.json，供 IntelliSense 使用");
+    ADD_OPTION_C("resolve-system-headers", ResolveSystemHeaders,
+                 "预先解析系统头文件路径与预定义宏并写入配置，加快 IntelliSense  启动");
+    ADD_OPTION_C("machine-profile", MachineProfile,
+                 "按机器配置限制 C/C++  扩展的资源占用。可为 auto、low、normal 或 server");
+    ADD_OPTION_C("fast-iteration", FastIteration,
+                 "使用编译器支持的更快的链接器与调试信息选项（mold/lld、split DWARF  等），并让 gdb "
+                 "仅按需加载共享库符号");
+    ADD_OPTION_C("judge-task", GenerateJudgeTask,
+                 "额外生成用 tests  文件夹中的 *.in/*.ans  评测当前程序的任务");
+    ADD_OPTION_C("bench-task", GenerateBenchTask,
+                 "额外生成多次运行当前程序并统计用时与硬件计数器的基准测试任务");
+    ADD_OPTION_C("release-lto", ReleaseLto, "在 release  与 release-native  任务中启用链接时优化（LTO）");
+    ADD_OPTION_C("pgo-task", GeneratePgoTasks,
+                 "额外生成配置文件引导优化（PGO）的任务链，并报告相对于 release 构建的加速比");
+    ADD_OPTION_C("profile-tasks", GenerateProfileTasks,
+                 "为已安装的  perf、valgrind、heaptrack  生成性能分析任务，结果保存在 profiles  中");
+    ADD_OPTION_C("lean-workbench", LeanWorkbench,
+                 "不监视、搜索编译产物，并禁用工作区不需要的内置扩展以降低 VS Code 负载");
     // ADD_OPTION_C("generate-test", GenerateTestFile, "");
 #ifdef WINDOWS
     ADD_OPTION_C("apply-nonascii-check", ApplyNonAsciiCheck,
@@ -213,10 +258,17 @@ void init(int argc, char** argv) {
     ADD_OPTION_C("open-vscode,o", OpenVscodeAfterConfig, "在配置完成后自动打开 VS Code");
     ADD_OPTION_C("no-send-analytics", NoSendAnalytics, "不发送统计信息");
     ADD_OPTION_A("check-update", CheckUpdate, "检查此工具可用的更新并退出");
+    ADD_OPTION_A("update-cache-ttl", UpdateCacheTtl,
+                 "检查更新时，缓存的版本信息在多少分钟内有效。默认为 60");
     ADD_OPTION_A("remove-scripts", RemoveScripts, "删除此程序注入的所有脚本并退出");
+    ADD_OPTION_A("install-toolchain", InstallToolchain,
+                 "下载并解压工具链压缩包，并使用其中的编译器。可多次给出作为镜像");
+    ADD_OPTION_A("toolchain-dir", ToolchainDir,
+                 "指定工具链的安装路径，默认为缓存文件夹中的 toolchain  文件夹");
+    ADD_OPTION_A("cache-dir", CacheDir, "指定预编译头文件等缓存的存放路径，可为多个用户共享");
 #ifdef WINDOWS
     ADD_OPTION_A("no-open-browser", NoOpenBrowser, "使用 GUI  时不自动打开浏览器");
-    ADD_OPTION_A("gui-address", GuiAddress, "指定使用 GUI  时自动打开的网页");
+    ADD_OPTION_A("gui-address", GuiAddress, "指定使用 GUI  时自动打开的网页，默认为内置的本地页面");
 #endif
 
     // other options that cannot be parsed directly
@@ -285,9 +337,6 @@ void init(int argc, char** argv) {
         LOG_ERR(languageText, "是不支持的目标语言。程序将退出");
         std::exit(1);
     }
-    if (options.GuiAddress.empty()) {
-        options.GuiAddress = DEFAULT_GUI_ADDRESS;
-    }
     if (vm.count("generate-test")) {
         options.GenerateTestFile = BaseOptions::GenTestType::Always;
     } else if (vm.count("no-generate-test")) {
@@ -301,7 +350,49 @@ void init(int argc, char** argv) {
 #undef ADD_OPTION_A
 }
 
+std::optional<int> runSubcommand(int argc, char** argv) {
+    if (argc < 2) return std::nullopt;
+    static const std::unordered_map<std::string_view, int (*)(int, char**)> subcommands{
+        {"bench", &Bench::benchCommand},
+        {"cache-stats", &Launcher::printStats},
+        {"compdb", &Workspace::compdbCommand},
+        {"debug-bench", &Debugger::benchmarkCommand},
+        {"download", &Downloader::downloadCommand},
+        {"fetch", &HttpClient::fetchCommand},
+        {"judge", &Judge::judgeCommand},
+        {"profile", &Profile::profileCommand},
+        {"run", &Runner::runCommand},
+        {"scan", &Scan::scanCommand},
+        {"spawn-bench", &Bench::spawnBenchCommand},
+    };
+    auto it{subcommands.find(argv[1])};
+    if (it == subcommands.end()) return std::nullopt;
+    Log::init(false);
+    return it->second(argc - 1, argv + 1);
+}
+
 void runCli(const Environment& env) {
+    if (!options.InstallToolchain.empty()) {
+        fs::path dir{options.ToolchainDir};
+        if (dir.empty()) {
+            dir = options.CacheDir.empty() ? Native::getCacheDir() / "vscch" : options.CacheDir;
+            dir /= "toolchain";
+        }
+        auto bin{Installer::installToolchain(options.InstallToolchain, dir)};
+        if (!bin) {
+            LOG_ERR("安装工具链失败。程序将退出。");
+            std::exit(1);
+        }
+        // Validated below as if passed from command line
+#ifdef WINDOWS
+        options.MingwPath = bin->string();
+#else
+        bool gcc{fs::exists(*bin / "g++")};
+        options.Compiler = (*bin / (options.Language == LanguageType::Cpp ? (gcc ? "g++" : "clang++")
+                                                                          : (gcc ? "gcc" : "clang")))
+                               .string();
+#endif
+    }
     std::unique_ptr<const CompilerInfo> pInfo;
     const auto& compilers{env.Compilers()};
 #ifdef WINDOWS
@@ -388,8 +479,9 @@ void runCli(const Environment& env) {
 #endif
     if (options.RemoveScripts) {
         LOG_INF("启用了开关 --remove-script，程序将删除所有脚本。");
+        // pause-console.sh/.rb are no longer installed outside Windows, but older versions did
         const char* filenames[]{"check-ascii.ps1", "pause-console-launcher.sh",
-                                "pause-console." SCRIPT_EXT};
+                                "pause-console." SCRIPT_EXT, SELF_FILENAME};
         for (const auto& filename : filenames) {
             auto scriptPath(Generator::scriptDirectory(options) / filename);
             if (fs::exists(scriptPath)) {
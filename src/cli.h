@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <optional>
+
 #include "generator.h"
 #include "environment.h"
 
@@ -30,6 +32,9 @@ struct ProgramOptions : CurrentOptions {
     bool NoOpenBrowser;
     std::string GuiAddress;
     bool CheckUpdate;
+    int UpdateCacheTtl{60};
+    std::vector<std::string> InstallToolchain;
+    std::string ToolchainDir;
 
     bool Help;
     bool Version;
@@ -39,6 +44,10 @@ extern ProgramOptions options;
 
 void init(int argc, char** argv);
 
+// Run `vscch <subcommand> ...` if argv[1] names one. Returns the exit code, or nullopt if it is an
+// ordinary invocation.
+std::optional<int> runSubcommand(int argc, char** argv);
+
 void runCli(const Environment& env);
 
 void checkUpdate();
@@ -0,0 +1,133 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+namespace Cpu {
+
+namespace {
+
+#if defined(__x86_64__) || defined(__i386__)
+
+struct Feature {
+    const char* name;
+    // cpuid leaf, subleaf, register (0-3 for eax-edx) and bit
+    unsigned leaf, subleaf, reg, bit;
+};
+
+const Feature X86_FEATURES[]{
+    {"cx16", 1, 0, 2, 13},
+    {"popcnt", 1, 0, 2, 23},
+    {"sse3", 1, 0, 2, 0},
+    {"ssse3", 1, 0, 2, 9},
+    {"sse4.1", 1, 0, 2, 19},
+    {"sse4.2", 1, 0, 2, 20},
+    {"avx", 1, 0, 2, 28},
+    {"f16c", 1, 0, 2, 29},
+    {"fma", 1, 0, 2, 12},
+    {"movbe", 1, 0, 2, 22},
+    {"bmi1", 7, 0, 1, 3},
+    {"avx2", 7, 0, 1, 5},
+    {"bmi2", 7, 0, 1, 8},
+    {"avx512f", 7, 0, 1, 16},
+    {"avx512dq", 7, 0, 1, 17},
+    {"avx512cd", 7, 0, 1, 28},
+    {"avx512bw", 7, 0, 1, 30},
+    {"avx512vl", 7, 0, 1, 31},
+    {"lahf_lm", 0x80000001, 0, 2, 0},
+    {"lzcnt", 0x80000001, 0, 2, 5},
+};
+
+// Whether the OS saves AVX (and AVX-512) registers on context switch
+bool osSupports(unsigned mask) {
+    unsigned a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & (1u << 27))) return false;  // OSXSAVE
+    unsigned lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (lo & mask) == mask;
+}
+
+Features detect() {
+    Features result;
+    bool avxOk{osSupports(0x6)};
+    bool avx512Ok{osSupports(0xe6)};
+    for (const auto& f : X86_FEATURES) {
+        unsigned regs[4];
+        if (!__get_cpuid_count(f.leaf, f.subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+            continue;
+        }
+        if (!(regs[f.reg] & (1u << f.bit))) continue;
+        std::string name{f.name};
+        bool needsAvxState{name.starts_with("avx") || name == "fma" || name == "f16c"};
+        if (name.starts_with("avx512") ? !avx512Ok : needsAvxState && !avxOk) continue;
+        result.Extensions.push_back(name);
+    }
+    auto has{[&](std::initializer_list<const char*> names) {
+        for (auto name : names) {
+            if (std::find(result.Extensions.begin(), result.Extensions.end(), name) ==
+                result.Extensions.end()) {
+                return false;
+            }
+        }
+        return true;
+    }};
+    // Levels defined by the x86-64 psABI
+    if (has({"cx16", "lahf_lm", "popcnt", "sse3", "sse4.1", "sse4.2", "ssse3"})) {
+        if (has({"avx", "avx2", "bmi1", "bmi2", "f16c", "fma", "lzcnt", "movbe"})) {
+            if (has({"avx512f", "avx512bw", "avx512cd", "avx512dq", "avx512vl"})) {
+                result.MarchLevel = "x86-64-v4";
+            } else {
+                result.MarchLevel = "x86-64-v3";
+            }
+        } else {
+            result.MarchLevel = "x86-64-v2";
+        }
+    } else {
+        result.MarchLevel = "x86-64";
+    }
+    return result;
+}
+
+#else
+
+Features detect() {
+    return {};
+}
+
+#endif
+
+}  // namespace
+
+const Features& features() {
+    static const Features result{detect()};
+    return result;
+}
+
+std::string describe() {
+    const auto& f{features()};
+    if (f.MarchLevel.empty()) return "unknown";
+    return f.MarchLevel + " (" + boost::join(f.Extensions, " ") + ")";
+}
+
+}  // namespace Cpu
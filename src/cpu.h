@@ -0,0 +1,39 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Instruction set features of the host CPU
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Cpu {
+
+struct Features {
+    // Names of detected ISA extensions, e.g. "avx2"
+    std::vector<std::string> Extensions;
+    // x86-64 micro-architecture level accepted by -march (e.g. "x86-64-v3"), empty if unknown
+    std::string MarchLevel;
+};
+
+const Features& features();
+
+// One line summary for diagnostics
+std::string describe();
+
+}  // namespace Cpu
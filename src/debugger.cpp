@@ -0,0 +1,127 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "debugger.h"
+
+#include <algorithm>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+
+#include "log.h"
+#include "native.h"
+
+namespace Debugger {
+
+namespace bp = boost::process;
+namespace po = boost::program_options;
+
+// debuginfod queries remote servers for every shared library, which hangs on offline machines
+const std::vector<std::string> FAST_STARTUP_COMMANDS{
+    "set debuginfod enabled off",
+};
+
+namespace {
+
+// Time from starting gdb to stopping at the first breakpoint, in milliseconds
+std::optional<double> timeToBreakpoint(const std::string& gdb, const std::string& program,
+                                       const std::string& location, bool fast) {
+    std::vector<std::string> args{"-nx", "-batch"};
+    if (fast) {
+        for (const auto& command : FAST_STARTUP_COMMANDS) {
+            args.insert(args.end(), {"-ex", command});
+        }
+        // What cpptools does for `symbolLoadInfo.loadAll = false`
+        args.insert(args.end(), {"-ex", "set auto-solib-add off"});
+    }
+    args.insert(args.end(), {"-ex", "break " + location, "-ex", "run", "-ex", "kill", program});
+    try {
+        auto start{std::chrono::steady_clock::now()};
+        using Stream = Native::SpawnOptions::Stream;
+        args.insert(args.begin(), gdb);
+        auto result{Native::spawn({.Args = std::move(args),
+                                   .Stdin = Stream::Null,
+                                   .Stdout = Stream::Null,
+                                   .Stderr = Stream::Null})};
+        if (!result || result->ExitCode != 0) return std::nullopt;
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    } catch (const std::exception& e) {
+        LOG_WRN("启动调试器失败：", e.what());
+        return std::nullopt;
+    }
+}
+
+}  // namespace
+
+int benchmarkCommand(int argc, char** argv) {
+    std::string gdb, program, location;
+    int runs;
+    // clang-format off
+    po::options_description desc("debug-bench Options", 79);
+    desc.add_options()
+        ("program", po::value(&program), "要调试的程序（需带有调试信息）")
+        ("debugger", po::value(&gdb)->default_value("gdb"), "调试器路径")
+        ("break,b", po::value(&location)->default_value("main"), "断点位置")
+        ("runs,n", po::value(&runs)->default_value(3), "重复次数，取最短时间")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("program", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || program.empty()) {
+        std::cout << "用法：vscch3 debug-bench <program> [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    if (gdb.find_first_of("/\\") == std::string::npos) {
+        gdb = bp::search_path(gdb).string();
+        if (gdb.empty()) {
+            LOG_ERR("未找到调试器。");
+            return 1;
+        }
+    }
+    for (bool fast : {false, true}) {
+        std::optional<double> best;
+        for (int i{0}; i < std::max(runs, 1); i++) {
+            auto time{timeToBreakpoint(gdb, program, location, fast)};
+            if (!time) break;
+            best = std::min(best.value_or(*time), *time);
+        }
+        std::cout << (fast ? "优化启动配置" : "默认启动配置") << "：";
+        if (best) {
+            std::cout << "到达断点 " << location << " 用时 " << std::fixed << std::setprecision(1)
+                      << *best << " ms" << std::endl;
+        } else {
+            std::cout << "调试器未能正常运行到断点。" << std::endl;
+        }
+    }
+    return 0;
+}
+
+}  // namespace Debugger
@@ -0,0 +1,38 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Debugger (gdb) startup tuning
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Debugger {
+
+// gdb commands which avoid network lookups at startup
+extern const std::vector<std::string> FAST_STARTUP_COMMANDS;
+
+// Shared libraries whose symbols are still loaded when eager loading is off (cpptools
+// `symbolLoadInfo.exceptionList` format). libstdc++ is kept since its pretty printers are loaded
+// together with its symbols.
+constexpr const char SYMBOL_LOAD_EXCEPTIONS[]{"libstdc++*"};
+
+// Subcommand `debug-bench`
+int benchmarkCommand(int argc, char** argv);
+
+}  // namespace Debugger
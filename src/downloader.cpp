@@ -0,0 +1,631 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "downloader.h"
+
+#include <httplib.h>
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+#include <openssl/evp.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/algorithm/string.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "log.h"
+
+namespace Downloader {
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+using namespace std::literals;
+
+namespace {
+
+constexpr auto CONNECT_TIMEOUT{5s};
+constexpr auto READ_TIMEOUT{15s};
+// Each mirror downloads at most this much (or for this long) while racing
+constexpr std::size_t PROBE_SIZE{256 * 1024};
+constexpr auto PROBE_DURATION{3s};
+constexpr int CHUNK_ATTEMPTS{3};
+
+struct Url {
+    // scheme://host[:port], as accepted by httplib::Client
+    std::string Origin;
+    std::string Path;
+    // Strong ETag or Last-Modified of the file on this mirror, sent as If-Range
+    std::string Validator;
+};
+
+std::optional<Url> splitUrl(const std::string& url) {
+    auto schemeEnd{url.find("://")};
+    if (schemeEnd == std::string::npos) return std::nullopt;
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (url.compare(0, schemeEnd, "https") == 0) {
+        LOG_WRN("此构建未启用 HTTPS 支持：", url);
+        return std::nullopt;
+    }
+#endif
+    auto pathStart{url.find('/', schemeEnd + 3)};
+    if (pathStart == std::string::npos) return Url{url, "/"};
+    return Url{url.substr(0, pathStart), url.substr(pathStart)};
+}
+
+std::unique_ptr<httplib::Client> makeClient(const Url& url) {
+    auto client{std::make_unique<httplib::Client>(url.Origin)};
+    client->set_connection_timeout(CONNECT_TIMEOUT);
+    client->set_read_timeout(READ_TIMEOUT);
+    client->set_follow_location(true);
+    return client;
+}
+
+// Total size from "Content-Range: bytes 0-99/1234"
+std::optional<std::size_t> totalFromContentRange(const std::string& value) {
+    auto slash{value.rfind('/')};
+    if (slash == std::string::npos || value.compare(slash + 1, 1, "*") == 0) return std::nullopt;
+    try {
+        return std::stoull(value.substr(slash + 1));
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+struct ProbeResult {
+    std::size_t mirror;
+    // Bytes per second
+    double speed{0};
+    bool acceptsRanges{false};
+    std::optional<std::size_t> size;
+    std::string validator;
+};
+
+// What identifies this version of the file, if the server tells. Weak ETags are not allowed in
+// If-Range.
+std::string validatorOf(const httplib::Response& res) {
+    auto etag{res.get_header_value("ETag")};
+    if (!etag.empty() && !etag.starts_with("W/")) return etag;
+    return res.get_header_value("Last-Modified");
+}
+
+// Request the beginning of the file from a mirror and measure its speed
+std::optional<ProbeResult> probe(std::size_t index, const std::string& mirror) {
+    auto url{splitUrl(mirror)};
+    if (!url) return std::nullopt;
+    auto client{makeClient(*url)};
+    ProbeResult result{index};
+    std::size_t received{0};
+    auto start{std::chrono::steady_clock::now()};
+    int status{-1};
+    client->Get(
+        url->Path.c_str(), {httplib::make_range_header({{0, PROBE_SIZE - 1}})},
+        [&](const httplib::Response& res) {
+            status = res.status;
+            result.validator = validatorOf(res);
+            if (status == 206) {
+                result.acceptsRanges = true;
+                result.size = totalFromContentRange(res.get_header_value("Content-Range"));
+            } else if (status == 200 && res.has_header("Content-Length")) {
+                result.size = std::stoull(res.get_header_value("Content-Length"));
+            }
+            return status == 200 || status == 206;
+        },
+        [&](const char*, std::size_t length) {
+            received += length;
+            // Enough to estimate the speed
+            return received < PROBE_SIZE &&
+                   std::chrono::steady_clock::now() - start < PROBE_DURATION;
+        });
+    if (status != 200 && status != 206) return std::nullopt;
+    auto elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    result.speed = received / std::max(elapsed, 1e-3);
+    LOG_DBG("Probe ", mirror, ": status ", status, ", ", result.speed / 1024, " KiB/s");
+    return result;
+}
+
+// Race all mirrors. Reachable ones are returned, those which support ranged requests first, then
+// the faster ones
+std::vector<ProbeResult> probeAll(const std::vector<std::string>& mirrors) {
+    std::vector<std::optional<ProbeResult>> probes(mirrors.size());
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t i{0}; i < mirrors.size(); i++) {
+            threads.emplace_back([&, i] { probes[i] = probe(i, mirrors[i]); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+    std::vector<ProbeResult> available;
+    for (auto& p : probes) {
+        if (p) available.push_back(*p);
+    }
+    std::sort(available.begin(), available.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.acceptsRanges, a.speed) > std::tie(b.acceptsRanges, b.speed);
+    });
+    return available;
+}
+
+// Which chunks are done, kept next to the partial file so that an interrupted download resumes.
+// The validators of the mirrors are recorded too, so that a file republished with the same size
+// is not merged with the old chunks.
+class State {
+    fs::path path;
+    std::mutex mutex;
+    std::size_t size, chunkSize;
+    std::map<std::string, std::string> validators;
+    std::vector<bool> done;
+
+    void save() {
+        nlohmann::json doneList(nlohmann::json::array());
+        for (std::size_t i{0}; i < done.size(); i++) {
+            if (done[i]) doneList.push_back(i);
+        }
+        auto j(nlohmann::json::object({{"size", size},
+                                       {"chunkSize", chunkSize},
+                                       {"validators", validators},
+                                       {"done", doneList}}));
+        auto tempPath{fs::path(path).concat(".tmp")};
+        fs::save_string_file(tempPath, j.dump());
+        fs::rename(tempPath, path);
+    }
+
+public:
+    // `validators` maps mirror URLs to their validators
+    State(const fs::path& path, std::size_t size, std::size_t chunkSize,
+          std::map<std::string, std::string> validators)
+        : path(path), size(size), chunkSize(chunkSize), validators(std::move(validators)),
+          done((size + chunkSize - 1) / chunkSize, false) {}
+
+    // Returns whether the previous progress is compatible and loaded. It is if some mirror still
+    // serves the version recorded then, and no mirror serves another one.
+    bool load() {
+        if (!fs::exists(path)) return false;
+        try {
+            std::string content;
+            fs::load_string_file(path, content);
+            auto j(nlohmann::json::parse(content));
+            if (j.at("size").get<std::size_t>() != size ||
+                j.at("chunkSize").get<std::size_t>() != chunkSize) {
+                return false;
+            }
+            auto previous{j.at("validators").get<std::map<std::string, std::string>>()};
+            bool matched{false};
+            for (const auto& [mirror, validator] : validators) {
+                auto it{previous.find(mirror)};
+                if (it == previous.end()) continue;
+                if (validator.empty() || it->second != validator) return false;
+                matched = true;
+            }
+            if (!matched) return false;
+            for (auto& i : j.at("done")) {
+                done.at(i.get<std::size_t>()) = true;
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    std::size_t chunks() const {
+        return done.size();
+    }
+    bool isDone(std::size_t i) {
+        std::lock_guard lock(mutex);
+        return done[i];
+    }
+    std::size_t doneCount() {
+        std::lock_guard lock(mutex);
+        return std::count(done.begin(), done.end(), true);
+    }
+    void markDone(std::size_t i) {
+        std::lock_guard lock(mutex);
+        done[i] = true;
+        save();
+    }
+    // Start over
+    void reset() {
+        std::lock_guard lock(mutex);
+        std::fill(done.begin(), done.end(), false);
+    }
+    void remove() {
+        boost::system::error_code ec;
+        fs::remove(path, ec);
+    }
+};
+
+// fseek with 64-bit offsets (long is 32-bit on Windows)
+bool seek(std::FILE* file, std::uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// Download [begin, end) of the file into the same range of `file`
+bool fetchRange(const Url& url, std::FILE* file, std::size_t begin, std::size_t end) {
+    auto client{makeClient(url)};
+    std::size_t offset{begin};
+    if (!seek(file, begin)) return false;
+    httplib::Headers headers{httplib::make_range_header(
+        {{static_cast<ssize_t>(begin), static_cast<ssize_t>(end - 1)}})};
+    if (!url.Validator.empty()) {
+        // If the file has changed since the probe, the server sends all of it with 200
+        headers.emplace("If-Range", url.Validator);
+    }
+    int status{-1};
+    auto res{client->Get(
+        url.Path.c_str(), headers,
+        [&](const httplib::Response& res) {
+            status = res.status;
+            if (status == 200) {
+                LOG_WRN(url.Origin, url.Path, " 上的文件已改变或不支持分段下载。");
+            }
+            // A server ignoring Range (or If-Range not matching) would send the whole file
+            return status == 206;
+        },
+        [&](const char* data, std::size_t length) {
+            if (offset + length > end) return false;
+            if (std::fwrite(data, 1, length, file) != length) return false;
+            offset += length;
+            return true;
+        })};
+    return res && status == 206 && offset == end && std::fflush(file) == 0;
+}
+
+// Fallback when no mirror supports ranged requests
+bool fetchWhole(const Url& url, const fs::path& path) {
+    auto client{makeClient(url)};
+    std::FILE* file{boost::nowide::fopen(path.string().c_str(), "wb")};
+    if (!file) return false;
+    int status{-1};
+    auto res{client->Get(
+        url.Path.c_str(),
+        [&](const httplib::Response& res) {
+            status = res.status;
+            return status == 200;
+        },
+        [&](const char* data, std::size_t length) {
+            return std::fwrite(data, 1, length, file) == length;
+        })};
+    bool written{std::fclose(file) == 0};
+    return res && status == 200 && written;
+}
+
+bool verify(const fs::path& path, const std::string& expected) {
+    if (expected.empty()) {
+        LOG_WRN("未提供 SHA-256 校验值，将不校验下载的文件。");
+        return true;
+    }
+    auto actual{sha256File(path)};
+    if (!boost::iequals(actual, expected)) {
+        LOG_ERR("文件校验失败：期望 SHA-256 为 ", expected, "，实际为 ", actual, "。");
+        return false;
+    }
+    LOG_INF("SHA-256 校验通过。");
+    return true;
+}
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+
+// FIPS 180-4 SHA-256, so that builds without TLS need not link OpenSSL
+class Sha256 {
+    static constexpr std::uint32_t K[64]{
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+        0xc67178f2};
+    std::uint32_t state[8]{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                           0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char block[64];
+    std::size_t blockSize{0};
+    std::uint64_t totalBits{0};
+
+    static std::uint32_t rotr(std::uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void transform() {
+        std::uint32_t w[64];
+        for (int i{0}; i < 16; i++) {
+            w[i] = std::uint32_t(block[i * 4]) << 24 | std::uint32_t(block[i * 4 + 1]) << 16 |
+                   std::uint32_t(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+        }
+        for (int i{16}; i < 64; i++) {
+            auto s0{rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3)};
+            auto s1{rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10)};
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto [a, b, c, d, e, f, g, h]{state};
+        for (int i{0}; i < 64; i++) {
+            auto t1{h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] +
+                    w[i]};
+            auto t2{(rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c))};
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        std::uint32_t add[8]{a, b, c, d, e, f, g, h};
+        for (int i{0}; i < 8; i++) {
+            state[i] += add[i];
+        }
+    }
+
+public:
+    void update(const char* data, std::size_t size) {
+        totalBits += std::uint64_t(size) * 8;
+        for (std::size_t i{0}; i < size; i++) {
+            block[blockSize++] = static_cast<unsigned char>(data[i]);
+            if (blockSize == 64) {
+                transform();
+                blockSize = 0;
+            }
+        }
+    }
+
+    std::array<unsigned char, 32> final() {
+        auto bits{totalBits};
+        char pad[72]{static_cast<char>(0x80)};
+        auto padSize{(blockSize < 56 ? 56 : 120) - blockSize};
+        for (int i{0}; i < 8; i++) {
+            pad[padSize + i] = static_cast<char>(bits >> (56 - i * 8));
+        }
+        update(pad, padSize + 8);
+        std::array<unsigned char, 32> digest;
+        for (int i{0}; i < 32; i++) {
+            digest[i] = static_cast<unsigned char>(state[i / 4] >> (24 - i % 4 * 8));
+        }
+        return digest;
+    }
+};
+
+#endif
+
+}  // namespace
+
+std::string sha256File(const fs::path& path) {
+    std::FILE* file{boost::nowide::fopen(path.string().c_str(), "rb")};
+    if (!file) return "";
+    std::vector<char> buffer(1 << 20);
+    std::size_t n;
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+    Sha256 hasher;
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        hasher.update(buffer.data(), n);
+    }
+    std::fclose(file);
+    auto digest{hasher.final()};
+    unsigned int length{digest.size()};
+#else
+    auto ctx{EVP_MD_CTX_new()};
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        EVP_DigestUpdate(ctx, buffer.data(), n);
+    }
+    std::fclose(file);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length{0};
+    EVP_DigestFinal_ex(ctx, digest, &length);
+    EVP_MD_CTX_free(ctx);
+#endif
+    std::ostringstream oss;
+    for (unsigned int i{0}; i < length; i++) {
+        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(digest[i]);
+    }
+    return oss.str();
+}
+
+std::optional<std::size_t> fastestMirror(const std::vector<std::string>& mirrors) {
+    auto available{probeAll(mirrors)};
+    if (available.empty()) return std::nullopt;
+    // Ranges do not matter for a single stream
+    return std::max_element(available.begin(), available.end(), [](const auto& a, const auto& b) {
+               return a.speed < b.speed;
+           })->mirror;
+}
+
+bool fetch(const std::string& url, const std::function<bool(const char*, std::size_t)>& receiver) {
+    auto parts{splitUrl(url)};
+    if (!parts) return false;
+    auto client{makeClient(*parts)};
+    int status{-1};
+    auto res{client->Get(
+        parts->Path.c_str(),
+        [&](const httplib::Response& res) {
+            status = res.status;
+            return status == 200;
+        },
+        [&](const char* data, std::size_t length) { return receiver(data, length); })};
+    if (!res || status != 200) {
+        LOG_DBG("Fetch ", url, " failed: status ", status, ", error ",
+                static_cast<int>(res.error()));
+        return false;
+    }
+    return true;
+}
+
+bool download(const DownloadOptions& options) {
+    auto available{probeAll(options.Mirrors)};
+    if (available.empty()) {
+        LOG_ERR("所有镜像均无法访问。");
+        return false;
+    }
+    const auto& best{available.front()};
+    LOG_INF("选择镜像 ", options.Mirrors[best.mirror], "（约 ", std::fixed, std::setprecision(1),
+            best.speed / 1024 / 1024, " MiB/s）。");
+
+    auto partPath{fs::path(options.SavePath).concat(".part")};
+    auto statePath{fs::path(options.SavePath).concat(".state.json")};
+    if (!best.acceptsRanges || !best.size) {
+        LOG_WRN("镜像不支持分段下载，将整体下载。");
+        if (!fetchWhole(*splitUrl(options.Mirrors[best.mirror]), partPath)) {
+            LOG_ERR("下载失败。");
+            return false;
+        }
+    } else {
+        auto size{*best.size};
+        // Range-capable mirrors in order of speed; a failed chunk is retried on the next one
+        std::vector<Url> mirrors;
+        std::map<std::string, std::string> validators;
+        for (const auto& p : available) {
+            if (p.acceptsRanges && p.size == size) {
+                auto url{*splitUrl(options.Mirrors[p.mirror])};
+                url.Validator = p.validator;
+                mirrors.push_back(url);
+                validators[options.Mirrors[p.mirror]] = p.validator;
+            }
+        }
+        State state(statePath, size, options.ChunkSize, validators);
+        if (state.load() && fs::exists(partPath) && fs::file_size(partPath) == size) {
+            LOG_INF("继续之前的下载，已完成 ", state.doneCount(), "/", state.chunks(), " 段。");
+        } else {
+            state.reset();
+            std::FILE* file{boost::nowide::fopen(partPath.string().c_str(), "wb")};
+            if (!file) {
+                LOG_ERR("无法创建文件 ", partPath, "。");
+                return false;
+            }
+            std::fclose(file);
+            fs::resize_file(partPath, size);
+        }
+
+        std::atomic_size_t next{0};
+        std::atomic_bool failed{false};
+        std::vector<std::thread> workers;
+        auto connections{std::clamp<std::size_t>(options.Connections, 1, state.chunks())};
+        for (std::size_t w{0}; w < connections; w++) {
+            workers.emplace_back([&, w] {
+                std::FILE* file{boost::nowide::fopen(partPath.string().c_str(), "r+b")};
+                if (!file) {
+                    failed = true;
+                    return;
+                }
+                for (std::size_t i; !failed && (i = next++) < state.chunks();) {
+                    if (state.isDone(i)) continue;
+                    auto begin{i * options.ChunkSize};
+                    auto end{std::min(begin + options.ChunkSize, size)};
+                    bool ok{false};
+                    for (int attempt{0}; attempt < CHUNK_ATTEMPTS && !ok; attempt++) {
+                        ok = fetchRange(mirrors[(w + attempt) % mirrors.size()], file, begin, end);
+                    }
+                    if (!ok) {
+                        LOG_ERR("第 ", i + 1, " 段下载失败。");
+                        failed = true;
+                        break;
+                    }
+                    state.markDone(i);
+                    LOG_DBG("Chunk ", i + 1, "/", state.chunks(), " done");
+                }
+                std::fclose(file);
+            });
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (failed) {
+            LOG_ERR("下载未完成，再次运行将继续下载。");
+            return false;
+        }
+        state.remove();
+    }
+
+    if (!verify(partPath, options.Sha256)) {
+        boost::system::error_code ec;
+        fs::remove(partPath, ec);
+        return false;
+    }
+    fs::rename(partPath, options.SavePath);
+    LOG_INF("已下载到 ", options.SavePath, "。");
+    return true;
+}
+
+int downloadCommand(int argc, char** argv) {
+    DownloadOptions options;
+    std::string savePath;
+    std::size_t chunkSizeMiB;
+    // clang-format off
+    po::options_description desc("download Options", 79);
+    desc.add_options()
+        ("url", po::value(&options.Mirrors), "文件的下载地址，可给出多个镜像")
+        ("output,o", po::value(&savePath), "保存路径，默认为地址中的文件名")
+        ("sha256", po::value(&options.Sha256), "期望的 SHA-256 校验值")
+        ("connections,j", po::value(&options.Connections)->default_value(4), "同时下载的连接数")
+        ("chunk-size", po::value(&chunkSizeMiB)->default_value(4), "每段的大小（MiB）")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("url", -1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || options.Mirrors.empty()) {
+        std::cout << "用法：vscch3 download <url> [<mirror url>...] [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    for (const auto& mirror : options.Mirrors) {
+        if (!splitUrl(mirror)) {
+            LOG_ERR(mirror, " 不是有效的地址。");
+            return 1;
+        }
+    }
+    if (savePath.empty()) {
+        auto path{splitUrl(options.Mirrors.front())->Path};
+        savePath = fs::path(path.substr(0, path.find('?'))).filename().string();
+        if (savePath.empty() || savePath == "/") {
+            LOG_ERR("无法从地址中得到文件名，请使用 -o 指定保存路径。");
+            return 1;
+        }
+    }
+    options.SavePath = savePath;
+    options.ChunkSize = std::max<std::size_t>(chunkSizeMiB, 1) << 20;
+    return download(options) ? 0 : 1;
+}
+
+}  // namespace Downloader
@@ -0,0 +1,58 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Download engine for large artifacts (toolchains): mirror racing, parallel ranged requests,
+// resuming and hash verification
+
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Downloader {
+
+struct DownloadOptions {
+    // URLs of the same file
+    std::vector<std::string> Mirrors;
+    boost::filesystem::path SavePath;
+    // Expected SHA-256 in hex, skip verification if empty
+    std::string Sha256;
+    unsigned Connections{4};
+    std::size_t ChunkSize{4 << 20};
+};
+
+// Index of the fastest reachable mirror
+std::optional<std::size_t> fastestMirror(const std::vector<std::string>& mirrors);
+
+// Stream the body of `url` into `receiver`, which returns false to abort. Returns whether the whole
+// body is received
+bool fetch(const std::string& url, const std::function<bool(const char*, std::size_t)>& receiver);
+
+// Returns whether the file is downloaded (and verified) into SavePath
+bool download(const DownloadOptions& options);
+
+// Lowercase hex SHA-256 of a file, empty on failure
+std::string sha256File(const boost::filesystem::path& path);
+
+// Subcommand `download`
+int downloadCommand(int argc, char** argv);
+
+}  // namespace Downloader
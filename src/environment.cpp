@@ -150,7 +150,6 @@ std::unordered_set<std::string> Environment::getPaths() {
 #endif
 
 std::optional<std::string> Environment::testCompiler(const boost::filesystem::path& path) {
-    bp::ipstream is;
 #ifdef WINDOWS
     auto compilerPath{path / "g++.exe"};
     if (!fs::exists(compilerPath)) {
@@ -159,17 +158,15 @@ std::optional<std::string> Environment::testCompiler(const boost::filesystem::pa
 #else
     const auto& compilerPath{path};
 #endif
-    try {
-        bp::child proc(compilerPath, "--version", bp::std_out > is);
-        std::string versionText;
-        if (std::getline(is, versionText) && !versionText.empty()) {
-            proc.wait();
-            return boost::trim(versionText), versionText;
-        } else {
-            return std::nullopt;
-        }
-    } catch (bp::process_error& err) {
-        LOG_WRN("测试编译器 ", compilerPath.native(), " 时失败：", err.what());
+    auto result{Native::spawn({.Args = {compilerPath.string(), "--version"}})};
+    if (!result) {
+        LOG_WRN("测试编译器 ", compilerPath.native(), " 时失败。");
+        return std::nullopt;
+    }
+    std::string versionText{result->Output.substr(0, result->Output.find('\n'))};
+    boost::trim(versionText);
+    if (versionText.empty()) {
         return std::nullopt;
     }
+    return versionText;
 }
\ No newline at end of file
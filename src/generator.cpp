@@ -21,13 +21,25 @@
 #include <boost/algorithm/string/regex.hpp>
 #include <boost/assign.hpp>
 #include <boost/process.hpp>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <sstream>
+#include <thread>
 
 #include "cli.h"
 #include "config.h"
+#include "cpu.h"
+#include "debugger.h"
+#include "environment.h"
+#include "launcher.h"
 #include "log.h"
+#include "native.h"
+#include "profile.h"
+#include "workspace.h"
 
 namespace bp = boost::process;
 namespace fs = boost::filesystem;
@@ -35,13 +47,10 @@ using namespace boost::assign;
 using namespace std::literals;
 
 std::string ExtensionManager::runScript(const std::initializer_list<std::string>& args) {
-    bp::ipstream is;
-    bp::child proc(scriptPath, std::vector(args), bp::std_out > is);
-    proc.wait();
-    std::ostringstream oss;
-    std::copy(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>(),
-              std::ostreambuf_iterator<char>(oss));
-    return oss.str();
+    std::vector<std::string> argv{scriptPath.string()};
+    argv.insert(argv.end(), args);
+    auto result{Native::spawn({.Args = std::move(argv)})};
+    return result ? result->Output : "";
 }
 
 ExtensionManager::ExtensionManager(const boost::filesystem::path& vscodePath)
@@ -123,14 +132,140 @@ ContainerT<std::string> splitPath(std::optional<std::string> (*getter)(const std
     return container;
 }
 
+// FNV-1a. Unlike std::hash, it is stable between runs and builds, so it can be used as the key
+// of shared cache entries.
+std::string hashText(const std::string& text) {
+    std::uint64_t hash{14695981039346656037ull};
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return oss.str();
+}
+
+// Other users may read the cache at the same time, so never leave a half-written file there.
+void saveFileAtomic(const fs::path& path, const std::string& content) {
+    auto tempPath{fs::unique_path(path.string() + ".%%%%%%")};
+    fs::save_string_file(tempPath, content);
+    fs::rename(tempPath, path);
+}
+
+// Quote an argument for the shell, used in generated Makefile/build.ninja
+std::string quoteArg(const std::string& arg) {
+    if (arg.find_first_of(" \t\"") == std::string::npos) return arg;
+    return "\"" + boost::replace_all_copy(arg, "\"", "\\\"") + "\"";
+}
+
+std::string ninjaEscape(const std::string& path) {
+    auto result{boost::replace_all_copy(path, "$", "$$")};
+    boost::replace_all(result, " ", "$ ");
+    boost::replace_all(result, ":", "$:");
+    return result;
+}
+
+// Built-in extensions that a C/C++ workspace does not need. They can only be disabled by command
+// line; their auto detection is turned off in settings anyway.
+const char* const UNNEEDED_BUILTIN_EXTENSIONS[]{
+    "vscode.npm",
+    "vscode.grunt",
+    "vscode.gulp",
+    "vscode.jake",
+    "vscode.typescript-language-features",
+};
+
+const char PROJECT_TARGET[]{"main." EXE_EXT};
+const char UNITY_TARGET[]{"unity." EXE_EXT};
+
+const char PROBE_CPP_SOURCE[]{R"(#include <iostream>
+int main() { std::cout << "Hello, world!" << std::endl; }
+)"};
+
+const char PROBE_C_SOURCE[]{R"(#include <stdio.h>
+int main(void) { printf("Hello, world!\n"); }
+)"};
+
+const char PCH_CPP_HEADER[]{R"(#if __has_include(<bits/stdc++.h>)
+#include <bits/stdc++.h>
+#else
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#endif
+)"};
+
+const char PCH_C_HEADER[]{R"(#include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+)"};
+
 }  // namespace
 
-Generator::Generator(CurrentOptions options) : options{options} {}
+Generator::Generator(CurrentOptions options, std::optional<nlohmann::json> replay)
+    : options{options}, hostInputs(replay.value_or(nlohmann::json::object())),
+      replaying{replay.has_value()} {}
+
+template <typename T, typename F>
+T Generator::hostInput(const char* key, F probe) {
+    if (!hostInputs.contains(key)) {
+        if (replaying) {
+            // Not recorded by older versions. The default makes the files look outdated.
+            LOG_DBG("Host input ", key, " not recorded");
+            return T{};
+        }
+        hostInputs[key] = probe();
+    }
+    try {
+        return hostInputs[key].get<T>();
+    } catch (...) {
+        return T{};
+    }
+}
 
 const char* Generator::fileExt() {
     return options.Language == LanguageType::Cpp ? ".cpp" : ".c";
 }
 
+std::vector<std::string> Generator::sourceExtensions() {
+    if (options.Language == LanguageType::Cpp) {
+        return {".cpp", ".cc", ".cxx"};
+    } else {
+        return {".c"};
+    }
+}
+
 std::string Generator::compilerPath() {
 #ifdef WINDOWS
     const char* filename{options.Language == LanguageType::Cpp ? "g++.exe" : "gcc.exe"};
@@ -148,7 +283,359 @@ std::string Generator::debuggerPath() {
 #endif
 }
 std::string Generator::scriptPath(const std::string& filename) {
-    return (scriptDirectory(options) / filename).string();
+    // Under the home folder on Linux and macOS
+    fs::path dir{hostInput<std::string>("ScriptDirectory",
+                                        [&] { return scriptDirectory(options).string(); })};
+    return (dir / filename).string();
+}
+
+std::string Generator::projectBuildTool() {
+    if (options.ProjectBuild == "make") {
+#ifdef WINDOWS
+        return (fs::path(options.MingwPath) / "mingw32-make.exe").string();
+#else
+        return "make";
+#endif
+    } else {
+        auto path{bp::search_path("ninja")};
+        if (path.empty()) {
+            LOG_WRN("未找到 Ninja。请安装 Ninja 后再使用项目构建任务。");
+            return "ninja";
+        }
+        return path.string();
+    }
+}
+
+fs::path Generator::cacheDirectory() {
+    if (!options.CacheDir.empty()) {
+        return fs::path(options.CacheDir);
+    }
+    return Native::getCacheDir() / "vscch";
+}
+
+std::optional<CompilerInfo> Generator::compilerInfo() {
+#ifdef WINDOWS
+    const auto& path{options.MingwPath};
+#else
+    const auto& path{options.Compiler};
+#endif
+    auto versionText{Environment::testCompiler(path)};
+    if (!versionText) {
+        return std::nullopt;
+    }
+    return CompilerInfo(path, *versionText);
+}
+
+std::optional<std::string> Generator::runCompiler(const std::vector<std::string>& args,
+                                                  const fs::path& cwd) {
+    LOG_DBG("Run: ", compilerPath(), " ", boost::join(args, " "));
+    std::vector<std::string> argv{compilerPath()};
+    argv.insert(argv.end(), args.begin(), args.end());
+    auto result{Native::spawn({.Args = std::move(argv),
+                               .Cwd = cwd,
+                               .Stderr = Native::SpawnOptions::Stream::Capture})};
+    if (!result) {
+        LOG_WRN("运行编译器 ", compilerPath(), " 时失败。");
+        return std::nullopt;
+    }
+    if (result->ExitCode != 0) {
+        LOG_DBG(result->Output);
+        return std::nullopt;
+    }
+    return std::move(result->Output);
+}
+
+// GCC 15 ships the `std` module as bits/std.cc. Build it once into the cache directory, and let
+// tasks find it through a module mapper file.
+std::vector<std::string> Generator::prepareStdModule(const std::vector<std::string>& args) {
+    auto info{compilerInfo()};
+    if (options.Language != LanguageType::Cpp || !info ||
+        info->compilerType != CompilerInfo::Gcc) {
+        LOG_WRN("当前编译器不支持 import std。");
+        return {};
+    }
+    try {
+        if (std::stoi(info->VersionNumber) < 15) {
+            LOG_WRN("import std 需要 GCC 15 及以上版本，当前版本为 ", info->VersionNumber, "。");
+            return {};
+        }
+    } catch (...) {
+        LOG_WRN("无法解析编译器版本 ", info->VersionNumber, "。");
+        return {};
+    }
+    auto dir{cacheDirectory() / "modules" /
+             hashText(compilerPath() + '\n' + info->VersionText + '\n' + boost::join(args, " "))};
+    auto mapperPath{dir / "module.map"};
+    auto objectPath{dir / "std.o"};
+    if (fs::exists(mapperPath)) {
+        LOG_INF("使用已缓存的标准库模块 ", dir, "。");
+    } else {
+        LOG_INF("构建标准库模块 std 到 ", dir, " 中...");
+        // Build in a folder of its own and rename it into place, so that concurrent or interrupted
+        // builds never leave a partial module behind
+        auto tempDir{fs::unique_path(dir.string() + ".%%%%%%")};
+        fs::create_directories(tempDir);
+        auto buildArgs{args};
+        buildArgs += "-fmodules", "-fsearch-include-path", "-c", "bits/std.cc", "-o",
+            (tempDir / "std.o").string();
+        boost::system::error_code ec;
+        if (!runCompiler(buildArgs, tempDir)) {
+            LOG_WRN("构建标准库模块失败。");
+            fs::remove_all(tempDir, ec);
+            return {};
+        }
+        // Paths in the mapper are those after renaming
+        saveFileAtomic(tempDir / "module.map",
+                       "std " + (dir / "gcm.cache" / "std.gcm").string() + '\n');
+        if (fs::exists(dir) && !fs::exists(mapperPath)) {
+            // Left by older versions, which built in place
+            fs::remove_all(dir, ec);
+        }
+        fs::rename(tempDir, dir, ec);
+        if (ec) {
+            // Another build finished first
+            fs::remove_all(tempDir, ec);
+            if (!fs::exists(mapperPath)) {
+                LOG_WRN("无法保存标准库模块到 ", dir, "。");
+                return {};
+            }
+        }
+        LOG_INF("构建完成。");
+    }
+    return {"-fmodules", "-fmodule-mapper=" + mapperPath.string(), objectPath.string()};
+}
+
+// Ask the compiler for its builtin include paths and macros, just like what cpptools does for
+// `compilerPath` on every startup, and cache the result for this compiler/standard pair.
+std::optional<nlohmann::json> Generator::resolveSystemHeaders() {
+    using json = nlohmann::json;
+    auto info{compilerInfo()};
+    if (!info) {
+        LOG_WRN("无法获取编译器信息，不预先解析系统头文件路径。");
+        return std::nullopt;
+    }
+    bool isCpp{options.Language == LanguageType::Cpp};
+    auto cachePath{cacheDirectory() / "intellisense" /
+                   (hashText(compilerPath() + '\n' + info->VersionText + '\n' +
+                             options.LanguageStandard) +
+                    ".json")};
+    if (fs::exists(cachePath)) {
+        try {
+            std::string content;
+            fs::load_string_file(cachePath, content);
+            LOG_INF("使用已缓存的系统头文件路径与预定义宏 ", cachePath, "。");
+            return json::parse(content);
+        } catch (...) {
+            LOG_WRN("读取缓存 ", cachePath, " 失败，将重新解析。");
+        }
+    }
+    LOG_INF("解析编译器的系统头文件路径与预定义宏...");
+    auto output{runCompiler({"-E", "-v", "-dM", "-x", isCpp ? "c++" : "c",
+                             "-std=" + options.LanguageStandard,
+#ifdef WINDOWS
+                             "NUL"
+#else
+                             "/dev/null"
+#endif
+    })};
+    if (!output) {
+        LOG_WRN("解析失败。");
+        return std::nullopt;
+    }
+    auto includes(json::array());
+    auto frameworks(json::array());
+    auto defines(json::array());
+    std::istringstream iss(*output);
+    std::string line;
+    bool inSearchList{false};
+    while (std::getline(iss, line)) {
+        boost::trim_right(line);
+        if (line.starts_with("#include <...> search starts here:")) {
+            inSearchList = true;
+        } else if (line.starts_with("End of search list.")) {
+            inSearchList = false;
+        } else if (inSearchList && line.starts_with(" ")) {
+            boost::trim(line);
+            constexpr std::string_view frameworkSuffix{" (framework directory)"};
+            if (line.ends_with(frameworkSuffix)) {
+                line.resize(line.size() - frameworkSuffix.size());
+                frameworks += fs::path(line).lexically_normal().generic_string();
+            } else {
+                includes += fs::path(line).lexically_normal().generic_string();
+            }
+        } else if (line.starts_with("#define ")) {
+            // "#define NAME VALUE" -> "NAME=VALUE", and function-like "NAME(x)=VALUE"
+            auto macro{line.substr(8)};
+            auto nameEnd{macro.find_first_of(" (")};
+            if (nameEnd != std::string::npos && macro[nameEnd] == '(') {
+                nameEnd = macro.find(')', nameEnd);
+                if (nameEnd != std::string::npos) nameEnd++;
+            }
+            if (nameEnd == std::string::npos || nameEnd >= macro.size()) {
+                defines += macro;
+            } else {
+                defines += macro.substr(0, nameEnd) + "=" + boost::trim_copy(macro.substr(nameEnd));
+            }
+        }
+    }
+    if (includes.empty()) {
+        LOG_WRN("未能从编译器输出中找到系统头文件路径。");
+        return std::nullopt;
+    }
+    auto result(json::object({
+        {"includePath", includes},
+        {"macFrameworkPath", frameworks},
+        {"defines", defines}
+    }));
+    fs::create_directories(cachePath.parent_path());
+    saveFileAtomic(cachePath, result.dump());
+    LOG_INF("解析完成，共 ", includes.size(), " 个头文件路径，", defines.size(), " 个预定义宏。");
+    return result;
+}
+
+// Arguments shared by all build tasks, before source and output files
+std::vector<std::string> Generator::buildArgs() {
+    auto args{options.CompileArgs};
+    args += "-g";
+    args.insert(args.end(), fastIterationArgs.begin(), fastIterationArgs.end());
+    return args;
+}
+
+// Find out which of the faster linker/debug info options the compiler accepts, then compare the
+// build time with the default profile.
+std::vector<std::string> Generator::probeFastIteration() {
+    LOG_INF("检测可用的快速迭代编译选项...");
+    bool isCpp{options.Language == LanguageType::Cpp};
+    auto tempDir{fs::temp_directory_path() / fs::unique_path("vscch-probe-%%%%%%")};
+    fs::create_directories(tempDir);
+    auto sourcePath{tempDir / ("probe"s + fileExt())};
+    auto objectPath{tempDir / "probe.o"};
+    auto exePath{tempDir / ("probe." EXE_EXT)};
+    fs::save_string_file(sourcePath, isCpp ? PROBE_CPP_SOURCE : PROBE_C_SOURCE);
+
+    auto defaultArgs{options.CompileArgs};
+    defaultArgs += "-g";
+    auto accepts{[&](const std::vector<std::string>& flags) {
+        auto args{defaultArgs};
+        args.insert(args.end(), flags.begin(), flags.end());
+        args += sourcePath.string(), "-o", exePath.string();
+        return runCompiler(args, tempDir).has_value();
+    }};
+    std::vector<std::string> result;
+    for (auto linker : {"mold", "lld"}) {
+        if (accepts({"-fuse-ld="s + linker})) {
+            result += "-fuse-ld="s + linker;
+            break;
+        }
+    }
+    // Let the linker build the index gdb would otherwise compute at startup (GNU ld can't)
+    auto gdbIndexArgs{result};
+    gdbIndexArgs += "-Wl,--gdb-index";
+    if (accepts(gdbIndexArgs)) {
+        result += "-Wl,--gdb-index";
+    }
+    for (auto flag : {"-gsplit-dwarf", "-pipe", "-gz"}) {
+        if (accepts({flag})) {
+            result += flag;
+        }
+    }
+    LOG_INF("可用的快速迭代编译选项：", boost::join(result, " "));
+
+    // Best of 3 (compile, link), in milliseconds; nullopt if any run fails
+    auto measure{[&](const std::vector<std::string>& flags)
+                     -> std::optional<std::pair<double, double>> {
+        auto args{defaultArgs};
+        args.insert(args.end(), flags.begin(), flags.end());
+        auto compileArgs{args};
+        compileArgs += "-c", sourcePath.string(), "-o", objectPath.string();
+        auto linkArgs{args};
+        linkArgs += objectPath.string(), "-o", exePath.string();
+        double compileTime{1e9}, linkTime{1e9};
+        for (int i{0}; i < 3; i++) {
+            auto start{std::chrono::steady_clock::now()};
+            if (!runCompiler(compileArgs, tempDir)) return std::nullopt;
+            auto compiled{std::chrono::steady_clock::now()};
+            if (!runCompiler(linkArgs, tempDir)) return std::nullopt;
+            auto linked{std::chrono::steady_clock::now()};
+            compileTime = std::min(
+                compileTime, std::chrono::duration<double, std::milli>(compiled - start).count());
+            linkTime = std::min(
+                linkTime, std::chrono::duration<double, std::milli>(linked - compiled).count());
+        }
+        return std::pair{compileTime, linkTime};
+    }};
+    auto defaultTime{measure({})};
+    auto fastTime{measure(result)};
+    if (defaultTime && fastTime) {
+        LOG_INF(std::fixed, std::setprecision(1), "默认配置：编译 ", defaultTime->first,
+                " ms，链接 ", defaultTime->second, " ms；快速迭代配置：编译 ", fastTime->first,
+                " ms，链接 ", fastTime->second, " ms。");
+    } else {
+        LOG_WRN("测量编译与链接用时失败。");
+    }
+
+    boost::system::error_code ec;
+    fs::remove_all(tempDir, ec);
+    return result;
+}
+
+// Target this machine in release-native builds: the x86-64 micro-architecture level of the CPU if
+// the compiler knows it (GCC 11+, Clang 12+), otherwise let the compiler detect it.
+std::vector<std::string> Generator::nativeArchArgs() {
+#ifdef WINDOWS
+    const char nullDevice[]{"NUL"};
+#else
+    const char nullDevice[]{"/dev/null"};
+#endif
+    std::vector<std::string> candidates;
+    if (auto level{Cpu::features().MarchLevel}; !level.empty()) {
+        candidates += "-march=" + level;
+    }
+    candidates += "-march=native", "-mcpu=native";
+    for (const auto& arg : candidates) {
+        if (runCompiler({arg, "-x", "c", "-E", nullDevice})) {
+            return {arg};
+        }
+    }
+    LOG_WRN("编译器不支持针对本机 CPU 优化，release-native 任务将不指定目标架构。");
+    return {};
+}
+
+// Precompile the commonly used standard headers once per compiler and flag set. Both GCC and
+// Clang pick up `<header>.gch`/`<header>.pch` automatically when the header is `-include`d.
+std::vector<std::string> Generator::preparePch(const std::vector<std::string>& args) {
+    auto info{compilerInfo()};
+    if (!info) {
+        LOG_WRN("无法获取编译器信息，不使用预编译头文件。");
+        return {};
+    }
+    bool isCpp{options.Language == LanguageType::Cpp};
+    auto dir{cacheDirectory() / "pch" /
+             hashText(compilerPath() + '\n' + info->VersionText + '\n' + boost::join(args, " "))};
+    auto headerPath{dir / (isCpp ? "stdc++.h" : "stdc.h")};
+    fs::path pchPath{headerPath.string() +
+                     (info->compilerType == CompilerInfo::Clang ? ".pch" : ".gch")};
+    if (fs::exists(pchPath)) {
+        LOG_INF("使用已缓存的预编译头文件 ", pchPath, "。");
+    } else {
+        LOG_INF("构建预编译头文件 ", pchPath, " 中...");
+        fs::create_directories(dir);
+        if (!fs::exists(headerPath)) {
+            saveFileAtomic(headerPath, isCpp ? PCH_CPP_HEADER : PCH_C_HEADER);
+        }
+        auto tempPath{fs::unique_path(pchPath.string() + ".%%%%%%")};
+        auto buildArgs{args};
+        buildArgs += "-x", isCpp ? "c++-header" : "c-header", headerPath.string(), "-o",
+            tempPath.string();
+        if (!runCompiler(buildArgs)) {
+            LOG_WRN("构建预编译头文件失败。");
+            fs::remove(tempPath);
+            return {};
+        }
+        fs::rename(tempPath, pchPath);
+        LOG_INF("构建完成。");
+    }
+    return {"-include", headerPath.string(), "-Winvalid-pch"};
 }
 
 void Generator::saveFile(const fs::path& path, const char* content) {
@@ -166,6 +653,31 @@ void Generator::saveFile(const fs::path& path, const char* content) {
     }
 }
 
+// Tasks run subcommands of this program, so keep a copy of it beside the scripts
+void Generator::installSelf() {
+    auto target{scriptDirectory(options) / SELF_FILENAME};
+    auto self{Native::getExecutablePath()};
+    if (fs::exists(target) && fs::equivalent(self, target)) {
+        return;
+    }
+    LOG_INF("复制此程序到 ", target, " 中...");
+    try {
+        fs::create_directories(target.parent_path());
+        // Copy then rename, in case the old one is running
+        auto tempPath{fs::unique_path(target.string() + ".%%%%%%")};
+        fs::copy_file(self, tempPath);
+        fs::rename(tempPath, target);
+#ifndef WINDOWS
+        fs::permissions(target, fs::perms::owner_all | fs::perms::group_read |
+                                    fs::perms::group_exe | fs::perms::others_read |
+                                    fs::perms::others_exe);
+#endif
+        LOG_INF("复制完成。");
+    } catch (std::exception& e) {
+        LOG_WRN("复制此程序失败：", e.what());
+    }
+}
+
 void Generator::addKeybinding(const std::string& key, const std::string& command,
                               const std::string& args) {
     using json = nlohmann::json;
@@ -226,14 +738,41 @@ void Generator::addToPath(const fs::path& path) {
 void Generator::generateTasksJson(const fs::path& path) {
     using json = nlohmann::json;
     LOG_INF("生成 ", path, " ...");
-    auto args{options.CompileArgs};
-    args += "-g", "${file}", "-o",
-        "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT;
+    auto args{buildArgs()};
+    std::vector<std::string> stdArgs;
+    if (options.UseImportStd) {
+        stdArgs = hostInput<std::vector<std::string>>("StdModuleArgs",
+                                                      [&] { return prepareStdModule(args); });
+    }
+    // Release builds need the std module too, but not the (debug) PCH
+    auto moduleArgs{stdArgs};
+    bool usePch{stdArgs.empty() && (options.UsePch || options.UseImportStd)};
+    if (usePch) {
+        if (options.UseImportStd) {
+            LOG_WRN("无法使用 import std，改为使用预编译头文件。");
+        }
+        stdArgs = hostInput<std::vector<std::string>>("PchArgs", [&] { return preparePch(args); });
+        usePch = !stdArgs.empty();
+    }
+    args.insert(args.end(), stdArgs.begin(), stdArgs.end());
+    args += "${file}", "-o", "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT;
+    auto command{compilerPath()};
+    auto env(json::object());
+    if (launcher) {
+        args.insert(args.begin(), command);
+        command = launcher->Path;
+        env = Launcher::environment(*launcher, options.LauncherCacheDir,
+                                    options.LauncherCacheSize, usePch, "${workspaceFolder}");
+#ifdef WINDOWS
+        // Task options replace the global ones
+        env["Path"] = options.MingwPath + ";${env:Path}";
+#endif
+    }
     // clang-format off
     auto sfbTask(json::object({
         {"type", "process"}, // "cppbuild" won't apply options
         {"label", "gcc single file build"},
-        {"command", compilerPath()},
+        {"command", command},
         {"args", args},
         {"group", json::object({
             {"kind", "build"},
@@ -249,6 +788,33 @@ void Generator::generateTasksJson(const fs::path& path) {
         })},
         {"problemMatcher", "$gcc"}
     }));
+    if (!env.empty()) {
+        sfbTask["options"] = json::object({{"env", env}});
+    }
+    // Optimized builds of the same file. They are not the default build task, so F5 still debugs.
+    auto releaseTask{[&](const char* label, const std::vector<std::string>& optArgs,
+                         const std::string& output = "${fileDirname}" PATH_SLASH
+                                                     "${fileBasenameNoExtension}." EXE_EXT) {
+        auto releaseArgs{options.CompileArgs};
+        releaseArgs.insert(releaseArgs.end(), optArgs.begin(), optArgs.end());
+        releaseArgs += "-DNDEBUG";
+        if (options.ReleaseLto) {
+            releaseArgs += "-flto";
+        }
+        releaseArgs.insert(releaseArgs.end(), moduleArgs.begin(), moduleArgs.end());
+        releaseArgs += "${file}", "-o", output;
+        if (launcher) {
+            releaseArgs.insert(releaseArgs.begin(), compilerPath());
+        }
+        auto task(sfbTask);
+        task["label"] = label;
+        task["args"] = releaseArgs;
+        task["group"] = "build";
+        return task;
+    }};
+    auto nativeArgs{
+        hostInput<std::vector<std::string>>("NativeArchArgs", [&] { return nativeArchArgs(); })};
+    nativeArgs.insert(nativeArgs.begin(), "-O3");
     auto pauseTask(json::object({
         {"type", "shell"},
         {"label", "run and pause"},
@@ -270,10 +836,12 @@ void Generator::generateTasksJson(const fs::path& path) {
             "ByPass",
             "-NoProfile",
             "-File",
+            scriptPath("pause-console." SCRIPT_EXT),
 # else // LINUX
             "-e",
+            scriptPath(SELF_FILENAME),
+            "run",
 # endif
-            scriptPath("pause-console." SCRIPT_EXT),
 #endif
             json::object({
                 {"value", "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT },
@@ -314,11 +882,221 @@ void Generator::generateTasksJson(const fs::path& path) {
         {"problemMatcher", json::array()}
     }));
     auto allTasks(json::array({sfbTask}));
+    allTasks += releaseTask("release", {"-O2"});
+    allTasks += releaseTask("release-native", nativeArgs);
     if (options.UseExternalTerminal)
         allTasks += pauseTask;
 #ifdef WINDOWS
     if (options.ApplyNonAsciiCheck)
         allTasks += asciiTask;
+#endif
+    if (options.GenerateCompileCommands) {
+        allTasks += json::object({
+            {"type", "process"},
+            {"label", "update compile commands"},
+            {"command", scriptPath(SELF_FILENAME)},
+            {"args", json::array({"compdb", "-w", "${workspaceFolder}"})},
+            {"runOptions", json::object({
+                {"runOn", "folderOpen"}
+            })},
+            {"presentation", json::object({
+                {"reveal", "never"},
+                {"focus", false},
+                {"echo", false},
+                {"showReuseMessage", false},
+                {"panel", "dedicated"},
+                {"clear", true}
+            })},
+            {"problemMatcher", json::array()}
+        });
+    }
+#ifndef WINDOWS
+    if (options.GenerateJudgeTask) {
+        allTasks += json::object({
+            {"type", "process"},
+            {"label", "judge"},
+            {"command", scriptPath(SELF_FILENAME)},
+            {"args", json::array({
+                "judge",
+                "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT,
+                "-d",
+                "${fileDirname}" PATH_SLASH "tests"
+            })},
+            {"dependsOn", "release"},
+            {"presentation", json::object({
+                {"reveal", "always"},
+                {"focus", false},
+                {"echo", false},
+                {"showReuseMessage", false},
+                {"panel", "shared"},
+                {"clear", true}
+            })},
+            {"problemMatcher", json::array()}
+        });
+    }
+    if (options.GenerateBenchTask) {
+        allTasks += json::object({
+            {"type", "process"},
+            {"label", "benchmark"},
+            {"command", scriptPath(SELF_FILENAME)},
+            {"args", json::array({
+                "bench",
+                "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT,
+                "-n",
+                "${input:benchmarkRuns}"
+            })},
+            {"dependsOn", "release-native"},
+            {"presentation", json::object({
+                {"reveal", "always"},
+                {"focus", false},
+                {"echo", false},
+                {"showReuseMessage", false},
+                {"panel", "shared"},
+                {"clear", true}
+            })},
+            {"problemMatcher", json::array()}
+        });
+    }
+    if (options.GeneratePgoTasks) {
+        // Both builds must have the same output name, since GCC names the profile data after it
+        std::string pgoProgram{"${fileDirname}" PATH_SLASH
+                               "${fileBasenameNoExtension}-pgo." EXE_EXT};
+        std::string profileDir{"${fileDirname}" PATH_SLASH ".pgo" PATH_SLASH
+                               "${fileBasenameNoExtension}"};
+        auto runTask(json::object({
+            {"type", "process"},
+            {"command", scriptPath(SELF_FILENAME)},
+            {"options", json::object({
+                {"cwd", "${fileDirname}"}
+            })},
+            {"presentation", json::object({
+                {"reveal", "always"},
+                {"focus", false},
+                {"echo", false},
+                {"showReuseMessage", false},
+                {"panel", "shared"},
+                {"clear", true}
+            })},
+            {"problemMatcher", json::array()}
+        }));
+        auto instrumentTask(
+            releaseTask("pgo instrument", {"-O2", "-fprofile-generate=" + profileDir}, pgoProgram));
+        auto trainTask(runTask);
+        trainTask["label"] = "pgo train";
+        trainTask["args"] = json::array({"bench", pgoProgram, "-n", "1", "-w", "0", "--no-counters",
+                                         "-i", "${input:pgoInput}"});
+        trainTask["dependsOn"] = "pgo instrument";
+        // Code not reached by the training input is still optimized normally
+        auto optimizeTask(releaseTask("pgo optimize",
+                                      {"-O2", "-fprofile-use=" + profileDir,
+                                       "-fprofile-partial-training", "-Wno-missing-profile"},
+                                      pgoProgram));
+        optimizeTask["dependsOn"] = "pgo train";
+        auto reportTask(runTask);
+        reportTask["label"] = "pgo";
+        reportTask["args"] = json::array({"bench", pgoProgram, "-b",
+            "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT,
+            "-i", "${input:pgoInput}"});
+        reportTask["dependsOn"] = json::array({"pgo optimize", "release"});
+        reportTask["dependsOrder"] = "sequence";
+        allTasks += instrumentTask;
+        allTasks += trainTask;
+        allTasks += optimizeTask;
+        allTasks += reportTask;
+    }
+    if (options.GenerateProfileTasks) {
+        auto tools{hostInput<std::vector<std::string>>(
+            "ProfileTools", [] { return Profile::availableTools(); })};
+        if (tools.empty()) {
+            LOG_WRN("未找到 perf、valgrind 或 heaptrack，将不生成性能分析任务。");
+        } else {
+            LOG_INF("将为性能分析工具 ", boost::join(tools, "、"), " 生成任务。");
+        }
+        for (const auto& tool : tools) {
+            allTasks += json::object({
+                {"type", "process"},
+                {"label", "profile " + tool},
+                {"command", scriptPath(SELF_FILENAME)},
+                {"args", json::array({
+                    "profile",
+                    tool,
+                    "${fileDirname}" PATH_SLASH "${fileBasenameNoExtension}." EXE_EXT,
+                    "-o",
+                    "${workspaceFolder}" PATH_SLASH "profiles"
+                })},
+                {"options", json::object({
+                    {"cwd", "${fileDirname}"}
+                })},
+                // Optimized code, which still has symbols
+                {"dependsOn", "release"},
+                {"presentation", json::object({
+                    {"reveal", "always"},
+                    {"focus", true},
+                    {"echo", false},
+                    {"showReuseMessage", false},
+                    {"panel", "shared"},
+                    {"clear", true}
+                })},
+                {"problemMatcher", json::array()}
+            });
+        }
+    }
+#endif
+    if (!options.ProjectBuild.empty()) {
+        std::vector<std::string> projectArgs{"-f"};
+        if (options.ProjectBuild == "make") {
+            projectArgs += ".vscode/Makefile";
+        } else {
+            projectArgs += ".vscode/build.ninja";
+        }
+        auto jobs{hostInput<unsigned>(
+            "Jobs", [] { return std::max(1u, std::thread::hardware_concurrency()); })};
+        projectArgs += "-j", std::to_string(jobs);
+        auto buildTool{
+            hostInput<std::string>("ProjectBuildTool", [&] { return projectBuildTool(); })};
+        auto projectTask(json::object({
+            {"type", "process"},
+            {"label", "project build"},
+            {"command", buildTool},
+            {"args", projectArgs},
+            {"options", json::object({
+                {"cwd", "${workspaceFolder}"}
+            })},
+            {"group", "build"},
+            {"presentation", sfbTask["presentation"]},
+            {"problemMatcher", json::object({
+                {"base", "$gcc"},
+                {"fileLocation", json::array({"relative", "${workspaceFolder}"})}
+            })}
+        }));
+        if (!env.empty()) {
+            projectTask["options"]["env"] = env;
+        }
+        allTasks += projectTask;
+        if (options.UnityBuild) {
+            projectTask["label"] = "project unity build";
+            projectTask["args"] += "unity";
+            allTasks += projectTask;
+        }
+    }
+    auto inputs(json::array());
+#ifndef WINDOWS
+    if (options.GenerateBenchTask) {
+        inputs += json::object({
+            {"id", "benchmarkRuns"},
+            {"type", "promptString"},
+            {"description", "计时的运行次数"},
+            {"default", "10"}
+        });
+    }
+    if (options.GeneratePgoTasks) {
+        inputs += json::object({
+            {"id", "pgoInput"},
+            {"type", "promptString"},
+            {"description", "PGO 训练用的输入文件（相对于源文件所在文件夹，留空则无输入）"},
+            {"default", ""}
+        });
+    }
 #endif
     auto result(json::object({
         {"version", "2.0.0"},
@@ -340,11 +1118,172 @@ void Generator::generateTasksJson(const fs::path& path) {
 #endif
     }));
     // clang-format on
+    if (!inputs.empty()) {
+        result["inputs"] = inputs;
+    }
     auto resultStr{result.dump(2)};
     LOG_DBG(resultStr);
     fs::save_string_file(path, resultStr);
 }
 
+// Project build compiles every source file in the workspace into build/main.out, one object per
+// translation unit. The Makefile finds sources by itself, so new files need no reconfiguration.
+void Generator::generateMakefile(const fs::path& path) {
+    LOG_INF("生成 ", path, " ...");
+    auto flags{buildArgs()};
+    std::vector<std::string> patterns;
+    for (auto&& ext : sourceExtensions()) {
+        patterns.push_back("*" + ext);
+    }
+    auto compiler{quoteArg(compilerPath())};
+    if (launcher) {
+        compiler = quoteArg(launcher->Path) + " " + compiler;
+    }
+    std::ostringstream oss;
+    oss << "# Generated by VS Code Config Helper. Edit it only if you know what you are doing!\n";
+    oss << "# Run in workspace folder: make -f .vscode/Makefile [unity|clean]\n";
+    oss << "\n";
+    oss << "CC := " << compiler << "\n";
+    oss << "FLAGS := ";
+    for (auto&& flag : flags) {
+        oss << quoteArg(flag) << " ";
+    }
+    oss << "\n";
+    oss << "BUILD := " << Workspace::BUILD_DIR << "\n";
+    oss << "TARGET := $(BUILD)/" << PROJECT_TARGET << "\n";
+    oss << "UNITY_TARGET := $(BUILD)/" << UNITY_TARGET << "\n";
+    oss << "UNITY_SRC := $(BUILD)/unity" << fileExt() << "\n";
+    oss << "\n";
+#ifdef WINDOWS
+    oss << "mkdir = if not exist \"$(subst /,\\,$(1))\" mkdir \"$(subst /,\\,$(1))\"\n";
+    oss << "rmdir = if exist \"$(subst /,\\,$(1))\" rmdir /s /q \"$(subst /,\\,$(1))\"\n";
+#else
+    oss << "mkdir = mkdir -p $(1)\n";
+    oss << "rmdir = rm -rf $(1)\n";
+#endif
+    oss << "rwildcard = $(foreach d,$(wildcard $(1:=/*)),$(call rwildcard,$d,$2) "
+           "$(filter $(subst *,%,$2),$d))\n";
+    oss << "SRCS := $(patsubst ./%,%,$(filter-out ./$(BUILD)/%,$(call rwildcard,.,"
+        << boost::join(patterns, " ") << ")))\n";
+    oss << "OBJS := $(SRCS:%=$(BUILD)/obj/%.o)\n";
+    oss << "\n";
+    oss << ".PHONY: all unity clean\n";
+    oss << "all: $(TARGET)\n";
+    oss << "\n";
+    oss << "$(TARGET): $(OBJS)\n";
+    oss << "\t$(CC) $(FLAGS) $^ -o $@\n";
+    oss << "\n";
+    oss << "$(BUILD)/obj/%.o: %\n";
+    oss << "\t@$(call mkdir,$(@D))\n";
+    oss << "\t$(CC) $(FLAGS) -MMD -MP -c $< -o $@\n";
+    oss << "\n";
+    oss << "unity: $(UNITY_TARGET)\n";
+    oss << "\n";
+    oss << "$(UNITY_TARGET): $(UNITY_SRC)\n";
+    oss << "\t$(CC) $(FLAGS) $< -o $@\n";
+    oss << "\n";
+#ifdef WINDOWS
+    // cmd.exe cannot print the lines easily, use $(file) of GNU make 4
+    oss << "HASH := \\#\n";
+    oss << "define NEWLINE\n\n\nendef\n";
+    oss << "$(UNITY_SRC): $(SRCS) | $(BUILD)/\n";
+    oss << "\t$(file >$@,$(foreach s,$(SRCS),$(HASH)include \"../$(s)\"$(NEWLINE)))\n";
+    oss << "\n";
+    oss << "$(BUILD)/:\n";
+    oss << "\t@$(call mkdir,$@)\n";
+#else
+    oss << "$(UNITY_SRC): $(SRCS)\n";
+    oss << "\t@$(call mkdir,$(@D))\n";
+    oss << "\tprintf '#include \"../%s\"\\n' $(SRCS) > $@\n";
+#endif
+    oss << "\n";
+    oss << "clean:\n";
+    oss << "\t$(call rmdir,$(BUILD))\n";
+    oss << "\n";
+    oss << "-include $(OBJS:.o=.d)\n";
+    auto result{oss.str()};
+    LOG_DBG(result);
+    fs::save_string_file(path, result);
+}
+
+// Ninja cannot glob, so the source list is fixed at configuration time.
+void Generator::generateNinjaFile(const fs::path& path) {
+    LOG_INF("生成 ", path, " ...");
+    auto flags{buildArgs()};
+    auto compiler{quoteArg(compilerPath())};
+    if (launcher) {
+        compiler = quoteArg(launcher->Path) + " " + compiler;
+    }
+    auto sources{Workspace::listSources(options.WorkspacePath, sourceExtensions())};
+    LOG_INF("找到 ", sources.size(), " 个源文件。");
+    std::string buildDir{Workspace::BUILD_DIR};
+    std::ostringstream oss;
+    oss << "# Generated by VS Code Config Helper. Edit it only if you know what you are doing!\n";
+    oss << "# Run in workspace folder: ninja -f .vscode/build.ninja [unity]\n";
+    oss << "# Configure again after adding or removing source files.\n";
+    oss << "\n";
+    oss << "ninja_required_version = 1.3\n";
+    oss << "builddir = " << buildDir << "\n";
+    oss << "cc = " << compiler << "\n";
+    oss << "flags =";
+    for (auto&& flag : flags) {
+        oss << " " << quoteArg(flag);
+    }
+    oss << "\n\n";
+    oss << "rule cc\n";
+    oss << "  command = $cc $flags -MMD -MF $out.d -c $in -o $out\n";
+    oss << "  depfile = $out.d\n";
+    oss << "  deps = gcc\n";
+    oss << "  description = CC $in\n";
+    oss << "\n";
+    oss << "rule link\n";
+    oss << "  command = $cc $flags $in -o $out\n";
+    oss << "  description = LINK $out\n";
+    oss << "\n";
+    std::vector<std::string> objects;
+    for (auto&& source : sources) {
+        auto object{ninjaEscape(buildDir + "/obj/" + source + ".o")};
+        oss << "build " << object << ": cc " << ninjaEscape(source) << "\n";
+        objects.push_back(object);
+    }
+    auto target{buildDir + "/" + PROJECT_TARGET};
+    oss << "\n";
+    oss << "build " << target << ": link " << boost::join(objects, " ") << "\n";
+    oss << "default " << target << "\n";
+    oss << "\n";
+
+    std::ostringstream unity;
+    for (auto&& source : sources) {
+        unity << "#include \"../" << source << "\"\n";
+    }
+    auto unitySource{path.parent_path() / ("unity"s + fileExt())};
+    fs::save_string_file(unitySource, unity.str());
+    oss << "build " << buildDir << "/" << UNITY_TARGET << ": link .vscode/unity" << fileExt()
+        << "\n";
+    oss << "build unity: phony " << buildDir << "/" << UNITY_TARGET << "\n";
+    auto result{oss.str()};
+    LOG_DBG(result);
+    fs::save_string_file(path, result);
+}
+
+// Generator only records the arguments; the listing is done (and later redone incrementally by the
+// "update compile commands" task) in Workspace::updateCompileCommands.
+void Generator::generateCompileCommands(const fs::path& dotVscode) {
+    using json = nlohmann::json;
+    auto path{dotVscode / Workspace::COMPILE_COMMANDS};
+    LOG_INF("生成 ", path, " ...");
+    std::vector<std::string> arguments{compilerPath()};
+    arguments.insert(arguments.end(), options.CompileArgs.begin(), options.CompileArgs.end());
+    arguments += "-g";
+    auto cache(json::object({
+        {"arguments", arguments},
+        {"extensions", sourceExtensions()},
+        {"dirs", json::object()}
+    }));
+    fs::save_string_file(dotVscode / Workspace::COMPILE_COMMANDS_CACHE, cache.dump());
+    Workspace::updateCompileCommands(options.WorkspacePath);
+}
+
 void Generator::generateLaunchJson(const fs::path& path) {
     using json = nlohmann::json;
     LOG_INF("生成 ", path, " ...");
@@ -394,6 +1333,29 @@ void Generator::generateLaunchJson(const fs::path& path) {
         })}
     }));
     // clang-format on
+#ifndef MACOS
+    auto& config{result["configurations"][0]};
+    // debuginfod lookups hang gdb startup on offline machines, and cost no symbols when skipped
+    for (const auto& command : Debugger::FAST_STARTUP_COMMANDS) {
+        config["setupCommands"].push_back(
+            json::object({{"text", command}, {"ignoreFailures", true}}));
+    }
+    // Lazy symbol loading loses libc frames in backtraces (abort, assert...), so only on request
+    if (options.FastIteration) {
+        config["symbolLoadInfo"] = json::object(
+            {{"loadAll", false}, {"exceptionList", Debugger::SYMBOL_LOAD_EXCEPTIONS}});
+    }
+#endif
+    if (!options.ProjectBuild.empty()) {
+        auto projectConfig(result["configurations"][0]);
+        projectConfig["name"] = "project debug";
+        projectConfig["program"] =
+            "${workspaceFolder}/"s + Workspace::BUILD_DIR + "/" + PROJECT_TARGET;
+        projectConfig["cwd"] = "${workspaceFolder}";
+        projectConfig["preLaunchTask"] = "project build";
+        // Put it first so that F5 uses it by default
+        result["configurations"].insert(result["configurations"].begin(), projectConfig);
+    }
     auto resultStr{result.dump(2)};
     LOG_DBG(resultStr);
     fs::save_string_file(path, resultStr);
@@ -438,6 +1400,125 @@ void Generator::generatePropertiesJson(const fs::path& path) {
         })}
     }));
     // clang-format on
+    if (options.ResolveSystemHeaders) {
+        auto resolved(hostInput<nlohmann::json>("SystemHeaders", [&]() -> nlohmann::json {
+            if (auto result{resolveSystemHeaders()}) return *result;
+            return nullptr;
+        }));
+        if (resolved.is_object()) {
+            auto& config{result["configurations"][0]};
+            for (auto&& path : resolved.at("includePath")) {
+                config["includePath"] += path;
+            }
+            if (!resolved.at("macFrameworkPath").empty()) {
+                config["macFrameworkPath"] = resolved.at("macFrameworkPath");
+            }
+            config["defines"] = resolved.at("defines");
+            // An empty compilerPath stops cpptools from querying the compiler again
+            config["compilerPath"] = "";
+        }
+    }
+    if (options.GenerateCompileCommands) {
+        result["configurations"][0]["compileCommands"] =
+            "${workspaceFolder}/.vscode/"s + Workspace::COMPILE_COMMANDS;
+    }
+    auto resultStr{result.dump(2)};
+    LOG_DBG(resultStr);
+    fs::save_string_file(path, resultStr);
+}
+
+// cpptools takes every core and several GB of memory per window by default. Limit it according to
+// the machine, or to a preset ("low", "normal", "server") given by user.
+nlohmann::json Generator::cpptoolsSettings() {
+    using json = nlohmann::json;
+    auto cores{std::max(1u, std::thread::hardware_concurrency())};
+    auto memoryMb{Native::getPhysicalMemory() / 1024 / 1024};
+    auto profile{options.MachineProfile};
+    if (profile == "auto") {
+        if ((memoryMb != 0 && memoryMb <= 8 * 1024) || cores <= 4) {
+            profile = "low";
+        } else if (cores >= 32) {
+            // Probably shared by many users
+            profile = "server";
+        } else {
+            profile = "normal";
+        }
+        LOG_INF("检测到 ", cores, " 个处理器核心，", memoryMb, " MB 内存，选择 ", profile,
+                " 配置。");
+    }
+    auto settings(json::object());
+    if (profile == "low") {
+        settings["C_Cpp.maxConcurrentThreads"] = std::min(2u, cores);
+        settings["C_Cpp.maxCachedProcesses"] = 1;
+        settings["C_Cpp.intelliSenseMemoryLimit"] = 1024;
+        settings["C_Cpp.intelliSenseCacheSize"] = 512;
+        settings["C_Cpp.workspaceParsingPriority"] = "low";
+    } else if (profile == "normal") {
+        settings["C_Cpp.maxConcurrentThreads"] = std::max(2u, cores / 2);
+        settings["C_Cpp.intelliSenseMemoryLimit"] =
+            std::clamp<std::uint64_t>(memoryMb / 4, 1024, 4096);
+        settings["C_Cpp.intelliSenseCacheSize"] = 2048;
+        settings["C_Cpp.workspaceParsingPriority"] = "medium";
+    } else if (profile == "server") {
+        settings["C_Cpp.maxConcurrentThreads"] = 2;
+        settings["C_Cpp.maxCachedProcesses"] = 1;
+        settings["C_Cpp.intelliSenseMemoryLimit"] = 1024;
+        settings["C_Cpp.intelliSenseCacheSize"] = 256;
+        settings["C_Cpp.workspaceParsingPriority"] = "low";
+    } else {
+        LOG_WRN(profile, " 不是合法的机器配置。可选值为 auto、low、normal 或 server。");
+        return settings;
+    }
+    // Keep databases out of the (maybe network) workspace folder
+    auto cpptoolsCache{cacheDirectory() / "cpptools"};
+    auto workspaceKey{hashText(fs::absolute(options.WorkspacePath).lexically_normal().string())};
+    settings["C_Cpp.default.browse.databaseFilename"] =
+        (cpptoolsCache / "browse" / workspaceKey / "browse.vc.db").generic_string();
+    settings["C_Cpp.intelliSenseCachePath"] = (cpptoolsCache / "ipch").generic_string();
+    return settings;
+}
+
+// Build outputs are written beside sources on every build. Keep file watcher and search away from
+// them, and stop unrelated built-in extensions from scanning the workspace.
+nlohmann::json Generator::workbenchSettings() {
+    using json = nlohmann::json;
+    auto outputs(json::object({
+        {"**/*." EXE_EXT, true},
+        {"**/*.o", true},
+        {"**/*.d", true},
+        {"**/*.dwo", true},
+        {"**/*.gch", true},
+        {"**/*.gcda", true},
+        {"**/"s + Workspace::BUILD_DIR, true},
+    }));
+    auto watcherExclude(outputs);
+    watcherExclude["**/.git/objects/**"] = true;
+    watcherExclude["**/"s + Workspace::BUILD_DIR + "/**"] = true;
+    return json::object({
+        {"files.watcherExclude", watcherExclude},
+        {"search.exclude", outputs},
+        {"files.exclude", outputs},
+        {"npm.autoDetect", "off"},
+        {"grunt.autoDetect", "off"},
+        {"gulp.autoDetect", "off"},
+        {"jake.autoDetect", "off"},
+        {"typescript.tsc.autoDetect", "off"},
+        {"typescript.disableAutomaticTypeAcquisition", true},
+        {"git.autoRepositoryDetection", "openEditors"},
+    });
+}
+
+void Generator::generateSettingsJson(const fs::path& path) {
+    using json = nlohmann::json;
+    auto result(json::object());
+    if (!options.MachineProfile.empty()) {
+        result.update(cpptoolsSettings());
+    }
+    if (options.LeanWorkbench) {
+        result.update(workbenchSettings());
+    }
+    if (result.empty()) return;
+    LOG_INF("生成 ", path, " ...");
     auto resultStr{result.dump(2)};
     LOG_DBG(resultStr);
     fs::save_string_file(path, resultStr);
@@ -537,12 +1618,18 @@ void Generator::openVscode(const std::optional<std::string>& filename) {
     if (filename) {
         args += "--goto", *filename;
     }
+    if (options.LeanWorkbench) {
+        for (auto&& id : UNNEEDED_BUILTIN_EXTENSIONS) {
+            args += "--disable-extension", id;
+        }
+    }
     LOG_INF("启动 VS Code...");
     LOG_DBG(options.VscodePath, boost::join(args, " "));
-    try {
-        bp::spawn(options.VscodePath, bp::args = args, bp::std_out > bp::null);
-    } catch (std::exception& e) {
-        LOG_WRN("启动 VS Code 失败：", e.what());
+    args.insert(args.begin(), options.VscodePath);
+    if (!Native::spawn({.Args = std::move(args),
+                        .Stdout = Native::SpawnOptions::Stream::Null,
+                        .Detach = true})) {
+        LOG_WRN("启动 VS Code 失败。");
     }
 }
 
@@ -554,8 +1641,14 @@ void Generator::generateShortcut() {
         fs::remove(shortcutPath);
     }
     auto targetPath{fs::absolute(options.WorkspacePath).string()};
+    auto args{"\"" + targetPath + "\""};
+    if (options.LeanWorkbench) {
+        for (auto&& id : UNNEEDED_BUILTIN_EXTENSIONS) {
+            args += " --disable-extension "s + id;
+        }
+    }
     auto result{Native::createLink(shortcutPath.string(), options.VscodePath,
-                                   "Open VS Code at " + targetPath, "\"" + targetPath + "\"")};
+                                   "Open VS Code at " + targetPath, args)};
     if (result) {
         LOG_INF("快捷方式 ", shortcutPath, " 已生成。");
     } else {
@@ -576,9 +1669,150 @@ boost::filesystem::path Generator::scriptDirectory(const CurrentOptions& opt) {
 #endif
 }
 
+nlohmann::json Generator::generateConfigs(const fs::path& dotVscode) {
+    fs::create_directories(dotVscode);
+    if (!replaying) {
+        LOG_DBG("CPU: ", Cpu::describe());
+    }
+    auto launcherInput(hostInput<nlohmann::json>("Launcher", [&]() -> nlohmann::json {
+        auto detected{Launcher::detect(options.CompilerLauncher)};
+        if (!detected) return nullptr;
+        return {{"Type", detected->launcherType == Launcher::LauncherInfo::Ccache ? "ccache"
+                                                                                 : "sccache"},
+                {"Path", detected->Path}};
+    }));
+    launcher.reset();
+    if (launcherInput.is_object()) {
+        launcher = Launcher::LauncherInfo{
+            launcherInput.value("Type", "") == "ccache" ? Launcher::LauncherInfo::Ccache
+                                                        : Launcher::LauncherInfo::Sccache,
+            launcherInput.value("Path", "")};
+    }
+    if (options.FastIteration) {
+        fastIterationArgs = hostInput<std::vector<std::string>>(
+            "FastIterationArgs", [&] { return probeFastIteration(); });
+    }
+    if (options.ProjectBuild == "make") {
+        generateMakefile(dotVscode / "Makefile");
+    } else if (options.ProjectBuild == "ninja") {
+        generateNinjaFile(dotVscode / "build.ninja");
+    } else if (!options.ProjectBuild.empty()) {
+        LOG_WRN(options.ProjectBuild, " 不是支持的项目构建工具，将不生成项目构建任务。");
+        options.ProjectBuild.clear();
+    }
+    if (options.UnityBuild && options.ProjectBuild.empty()) {
+        LOG_WRN("未启用项目构建，将不生成 unity build 任务。");
+    }
+#ifdef WINDOWS
+    if (options.GenerateJudgeTask) {
+        LOG_WRN("评测功能暂不支持 Windows，将不生成评测任务。");
+    }
+    if (options.GenerateBenchTask) {
+        LOG_WRN("基准测试功能暂不支持 Windows，将不生成基准测试任务。");
+    }
+    if (options.GeneratePgoTasks) {
+        LOG_WRN("PGO 任务依赖基准测试功能，暂不支持 Windows，将不生成。");
+    }
+    if (options.GenerateProfileTasks) {
+        LOG_WRN("性能分析任务暂不支持 Windows，将不生成。");
+    }
+#else
+    if (options.GeneratePgoTasks) {
+        auto isGcc{hostInput<bool>("Gcc", [&] {
+            auto info{compilerInfo()};
+            return info && info->compilerType == CompilerInfo::Gcc;
+        })};
+        if (!isGcc) {
+            LOG_WRN("PGO 任务需要 GCC，将不生成。");
+            options.GeneratePgoTasks = false;
+        }
+    }
+#endif
+    generateTasksJson(dotVscode / "tasks.json");
+    generateLaunchJson(dotVscode / "launch.json");
+    generatePropertiesJson(dotVscode / "c_cpp_properties.json");
+    generateSettingsJson(dotVscode / "settings.json");
+    if (options.GenerateCompileCommands) {
+        generateCompileCommands(dotVscode);
+    }
+    auto fingerprints(nlohmann::json::object());
+    for (const char* filename : FINGERPRINTED_FILES) {
+        if (auto hash{fingerprint(dotVscode / filename)}) {
+            fingerprints[filename] = *hash;
+        }
+    }
+    return fingerprints;
+}
+
+void Generator::saveManifest(const fs::path& dotVscode, const nlohmann::json& fingerprints) {
+    auto manifest(nlohmann::json::object({{"Version", PROJECT_VERSION},
+                                          {"Options", optionsToJson(options)},
+                                          {"HostInputs", hostInputs},
+                                          {"Fingerprints", fingerprints}}));
+    saveFileAtomic(dotVscode / MANIFEST, manifest.dump(4));
+}
+
+std::optional<std::string> Generator::fingerprint(const fs::path& path) {
+    if (!fs::exists(path)) return std::nullopt;
+    std::string content;
+    fs::load_string_file(path, content);
+    return hashText(content);
+}
+
+// clang-format off
+#define COMMON_CONFIG_FIELDS(F)                                                                    \
+    F(VscodePath) F(WorkspacePath) F(Language) F(LanguageStandard) F(CompileArgs)                  \
+    F(UseExternalTerminal) F(UsePch) F(UseImportStd) F(CacheDir) F(CompilerLauncher)               \
+    F(LauncherCacheDir) F(LauncherCacheSize) F(ProjectBuild) F(UnityBuild)                         \
+    F(GenerateCompileCommands) F(ResolveSystemHeaders) F(MachineProfile) F(LeanWorkbench)          \
+    F(FastIteration) F(GenerateJudgeTask) F(GenerateBenchTask) F(ReleaseLto) F(GeneratePgoTasks)   \
+    F(GenerateProfileTasks)
+#ifdef WINDOWS
+# define CONFIG_FIELDS(F) COMMON_CONFIG_FIELDS(F) F(MingwPath) F(ApplyNonAsciiCheck)
+#else
+# define CONFIG_FIELDS(F) COMMON_CONFIG_FIELDS(F) F(Compiler)
+#endif
+// clang-format on
+
+nlohmann::json Generator::optionsToJson(const CurrentOptions& options) {
+    auto j(nlohmann::json::object());
+#define TO_JSON(field) j[#field] = options.field;
+    CONFIG_FIELDS(TO_JSON)
+#undef TO_JSON
+    return j;
+}
+
+CurrentOptions Generator::optionsFromJson(const nlohmann::json& j) {
+    CurrentOptions options{};
+#define FROM_JSON(field) \
+    if (j.contains(#field)) j.at(#field).get_to(options.field);
+    CONFIG_FIELDS(FROM_JSON)
+#undef FROM_JSON
+    // Nothing outside the configuration folder
+    options.ShouldInstallL10n = false;
+    options.ShouldUninstallExtensions = false;
+    options.GenerateTestFile = BaseOptions::GenTestType::Never;
+    options.OpenVscodeAfterConfig = false;
+    options.NoSendAnalytics = true;
+#ifdef WINDOWS
+    options.UseGui = false;
+    options.NoSetEnv = true;
+    options.GenerateDesktopShortcut = false;
+#endif
+    return options;
+}
+
+#undef CONFIG_FIELDS
+#undef COMMON_CONFIG_FIELDS
+
 void Generator::generate() {
     try {
         fs::path dotVscode(fs::path(options.WorkspacePath) / ".vscode");
+        // Sent in the background while configuring
+        std::future<bool> analytics;
+        if (!options.NoSendAnalytics) {
+            analytics = sendAnalytics();
+        }
 
         ExtensionManager extensions(options.VscodePath);
         if (options.ShouldUninstallExtensions) {
@@ -591,9 +1825,18 @@ void Generator::generate() {
         if (options.ShouldInstallL10n) {
             extensions.install("ms-ceintl.vscode-language-pack-zh-hans");
         }
+        if (options.GenerateCompileCommands
+#ifndef WINDOWS
+            || options.UseExternalTerminal || options.GenerateJudgeTask || options.GenerateBenchTask ||
+            options.GeneratePgoTasks || options.GenerateProfileTasks
+#endif
+        ) {
+            installSelf();
+        }
         if (options.UseExternalTerminal) {
+#ifdef WINDOWS
             saveFile(scriptDirectory(options) / "pause-console." SCRIPT_EXT, Embed::PAUSE_CONSOLE);
-#ifdef MACOS
+#elif defined(MACOS)
             saveFile(scriptDirectory(options) / "pause-console-launcher.sh",
                      Embed::PAUSE_CONSOLE_LAUNCHER);
 #endif
@@ -612,10 +1855,7 @@ void Generator::generate() {
             fs::remove_all(dotVscode);
             LOG_INF("移除了已存在的 .vscode 文件夹。");
         }
-        fs::create_directories(dotVscode);
-        generateTasksJson(dotVscode / "tasks.json");
-        generateLaunchJson(dotVscode / "launch.json");
-        generatePropertiesJson(dotVscode / "c_cpp_properties.json");
+        saveManifest(dotVscode, generateConfigs(dotVscode));
         if (options.GenerateTestFile == BaseOptions::GenTestType::Auto) {
             if (fs::exists(fs::path(options.WorkspacePath) / ("helloworld"s + fileExt()))) {
                 options.GenerateTestFile = BaseOptions::GenTestType::Never;
@@ -635,9 +1875,7 @@ void Generator::generate() {
             generateShortcut();
         }
 #endif
-        if (!options.NoSendAnalytics) {
-            sendAnalytics();
-        }
+        waitAnalytics(analytics);
         LOG_INF("配置完成。");
     } catch (std::exception& e) {
         LOG_ERR(e.what());
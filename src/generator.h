@@ -22,12 +22,17 @@
 #include <string_view>
 #include <unordered_set>
 #include <vector>
+#include <future>
 #include <optional>
 
 #include <boost/filesystem.hpp>
 
+#include "launcher.h"
+
 enum class LanguageType { Cpp, C };
 
+struct CompilerInfo;
+
 struct BaseOptions {
     enum class GenTestType { Auto, Always, Never };
 
@@ -38,6 +43,26 @@ struct BaseOptions {
     std::vector<std::string> CompileArgs;
     bool UseExternalTerminal;
 
+    // Options below are not exposed in GUI, so they need default values
+    bool UsePch{false};
+    bool UseImportStd{false};
+    std::string CacheDir;
+    std::string CompilerLauncher;
+    std::string LauncherCacheDir;
+    std::string LauncherCacheSize;
+    std::string ProjectBuild;
+    bool UnityBuild{false};
+    bool GenerateCompileCommands{false};
+    bool ResolveSystemHeaders{false};
+    std::string MachineProfile;
+    bool LeanWorkbench{false};
+    bool FastIteration{false};
+    bool GenerateJudgeTask{false};
+    bool GenerateBenchTask{false};
+    bool ReleaseLto{false};
+    bool GeneratePgoTasks{false};
+    bool GenerateProfileTasks{false};
+
     bool ShouldInstallL10n;
     bool OfflineInstallCCpp;
     bool ShouldUninstallExtensions;
@@ -106,30 +131,80 @@ public:
 
 class Generator {
     CurrentOptions options;
+    std::optional<Launcher::LauncherInfo> launcher;
+    std::vector<std::string> fastIterationArgs;
+    // What was found by probing this machine (tools, compiler features, CPU), saved in the
+    // manifest. When replaying, recorded values are used and nothing is probed or built.
+    nlohmann::json hostInputs;
+    bool replaying;
+
+    template <typename T, typename F>
+    T hostInput(const char* key, F probe);
 
     const char* fileExt();
+    std::vector<std::string> sourceExtensions();
     
     std::string compilerPath();
     std::string debuggerPath();
     std::string scriptPath(const std::string& filename);
+    std::string projectBuildTool();
+    boost::filesystem::path cacheDirectory();
+
+    std::optional<CompilerInfo> compilerInfo();
+    std::optional<std::string> runCompiler(const std::vector<std::string>& args,
+                                           const boost::filesystem::path& cwd = {});
+    std::vector<std::string> prepareStdModule(const std::vector<std::string>& args);
+    std::vector<std::string> preparePch(const std::vector<std::string>& args);
+    std::vector<std::string> buildArgs();
+    std::vector<std::string> probeFastIteration();
+    std::vector<std::string> nativeArchArgs();
+    std::optional<nlohmann::json> resolveSystemHeaders();
 
     void saveFile(const boost::filesystem::path& path, const char* content);
+    void installSelf();
     void addKeybinding(const std::string& key, const std::string& command, const std::string& args);
     void addToPath(const boost::filesystem::path& path);
 
     void generateTasksJson(const boost::filesystem::path& path);
     void generateLaunchJson(const boost::filesystem::path& path);
     void generatePropertiesJson(const boost::filesystem::path& path);
+    nlohmann::json cpptoolsSettings();
+    nlohmann::json workbenchSettings();
+    void generateSettingsJson(const boost::filesystem::path& path);
+    void generateMakefile(const boost::filesystem::path& path);
+    void generateNinjaFile(const boost::filesystem::path& path);
+    void generateCompileCommands(const boost::filesystem::path& dotVscode);
 
     std::string generateTestFile();
     void openVscode(const std::optional<std::string>& filepath);
     void generateShortcut();
-    void sendAnalytics();
+    std::future<bool> sendAnalytics();
+    void waitAnalytics(std::future<bool>& analytics);
 
 public:
-    Generator(CurrentOptions options);
+    // Written to .vscode along with generated files, recording options and fingerprints, so that
+    // `vscch3 scan` can find outdated or modified configurations
+    static constexpr const char MANIFEST[]{"vscch.json"};
+    // Files which are fingerprinted. Others depend on workspace content, or on the machine in ways
+    // not recorded as host inputs.
+    static constexpr const char* FINGERPRINTED_FILES[]{"tasks.json", "launch.json",
+                                                       "c_cpp_properties.json"};
+
+    // With `replay` (the host inputs of a manifest), generate what that machine would have
+    // generated, without running the compiler or any other tool.
+    Generator(CurrentOptions options, std::optional<nlohmann::json> replay = std::nullopt);
     void generate();
 
+    // Generate files into `dotVscode` only, without touching VS Code, scripts or environment.
+    // Returns fingerprints of FINGERPRINTED_FILES.
+    nlohmann::json generateConfigs(const boost::filesystem::path& dotVscode);
+    void saveManifest(const boost::filesystem::path& dotVscode, const nlohmann::json& fingerprints);
+
+    static std::optional<std::string> fingerprint(const boost::filesystem::path& path);
+    // Options which affect generated files, as saved in the manifest
+    static nlohmann::json optionsToJson(const CurrentOptions& options);
+    static CurrentOptions optionsFromJson(const nlohmann::json& j);
+
     static boost::filesystem::path scriptDirectory(const CurrentOptions& options);
 };
 
@@ -17,70 +17,364 @@
 
 // Functions which will download file from the Internet
 
+#include "http_client.h"
+
 #include <httplib.h>
 
-#include <boost/assign.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/process.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/program_options.hpp>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
 
+#include "cli.h"
 #include "config.h"
 #include "generator.h"
 #include "log.h"
 #include "native.h"
 
 using namespace std::literals;
-using namespace boost::assign;
 
 namespace {
-std::optional<std::string> download(const char* host, const char* path, const char* savePath = nullptr) {
-#ifdef WINDOWS
-    httplib::Client client(host);
-    client.set_connection_timeout(5000ms);
-    auto res{client.Get(path)};
-    if (res && res->status == 200) {
-        return res->body;
-    } else {
+
+constexpr auto CONNECT_TIMEOUT{5s};
+constexpr auto READ_TIMEOUT{10s};
+constexpr int MAX_ATTEMPTS{3};
+constexpr auto RETRY_DELAY{500ms};
+constexpr std::size_t WRITE_BUFFER_SIZE{64 * 1024};
+
+// Requests off the critical path give up early: one attempt with short timeouts, and the caller
+// stops waiting at the deadline anyway
+constexpr auto BACKGROUND_CONNECT_TIMEOUT{1500ms};
+constexpr auto BACKGROUND_READ_TIMEOUT{2s};
+constexpr auto UPDATE_DEADLINE{4s};
+constexpr auto ANALYTICS_DEADLINE{2s};
+
+const char* RELEASE_HOST{"https://api.github.com"};
+const char* RELEASE_PATH{"/repos/Guyutongxue/VSCodeConfigHelper3/releases/latest"};
+
+const char* ANALYTICS_HOST{"https://api.countapi.xyz"};
+const char* ANALYTICS_KEY{"guyutongxue.github.io/b54f2252-e54a-4bd0-b4c2-33b47db6aa98"};
+
+// Connection errors (no status), server errors and rate limiting may go away when retried later
+bool shouldRetry(int status) {
+    return status == -1 || status == 429 || status >= 500;
+}
+
+// Download from `host` + `path`. If `savePath` is given, the body is streamed into that file
+// (replaced only when the download succeeds) and an empty string is returned.
+std::optional<std::string> download(const char* host, const char* path,
+                                    const char* savePath = nullptr, bool background = false) {
+    namespace fs = boost::filesystem;
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (boost::starts_with(host, "https://")) {
+        LOG_DBG("HTTPS is not supported by builds without TLS: ", host, path);
         return std::nullopt;
     }
+#endif
+    std::optional<fs::path> tempPath;
     if (savePath) {
-        boost::filesystem::path p(savePath);
-        boost::filesystem::save_string_file(p, res->body);
-    }
-#else
-    namespace bp = boost::process;
-    auto curlPath{bp::search_path("curl")};
-    if (curlPath.empty()) {
-        LOG_ERR("需要 Curl 才能下载文件。当前系统未找到 Curl 安装。");
-        return std::nullopt;
+        tempPath = fs::path(savePath).concat(".part");
     }
-    bp::ipstream is;
-    std::vector args{std::string(host) + path, "--connect-timeout"s, "5"s};
-    if (savePath) {
-        args += "--output"s, savePath;
+    for (int attempt{1};; attempt++) {
+        httplib::Client client(host);
+        if (background) {
+            client.set_connection_timeout(BACKGROUND_CONNECT_TIMEOUT);
+            client.set_read_timeout(BACKGROUND_READ_TIMEOUT);
+        } else {
+            client.set_connection_timeout(CONNECT_TIMEOUT);
+            client.set_read_timeout(READ_TIMEOUT);
+        }
+        client.set_follow_location(true);
+
+        std::string body;
+        std::FILE* file{nullptr};
+        char buffer[WRITE_BUFFER_SIZE];
+        int status{-1};
+        auto res{client.Get(
+            path,
+            [&](const httplib::Response& response) {
+                status = response.status;
+                if (status != 200) return false;
+                if (tempPath) {
+                    file = boost::nowide::fopen(tempPath->string().c_str(), "wb");
+                    if (!file) return false;
+                    std::setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+                }
+                return true;
+            },
+            [&](const char* data, std::size_t length) {
+                if (file) {
+                    return std::fwrite(data, 1, length, file) == length;
+                }
+                body.append(data, length);
+                return true;
+            })};
+        bool written{true};
+        if (file) {
+            written = std::fclose(file) == 0;
+        }
+        if (res && status == 200 && written) {
+            if (tempPath) {
+                fs::rename(*tempPath, savePath);
+            }
+            return body;
+        }
+        if (tempPath) {
+            boost::system::error_code ec;
+            fs::remove(*tempPath, ec);
+        }
+        LOG_DBG("Download ", host, path, " failed (attempt ", attempt, "): status ", status,
+                ", error ", static_cast<int>(res.error()));
+        if (background || attempt == MAX_ATTEMPTS || !shouldRetry(status)) {
+            return std::nullopt;
+        }
+        std::this_thread::sleep_for(RETRY_DELAY * (1 << (attempt - 1)));
     }
-    bp::child curl(curlPath, args, bp::std_out > is, bp::std_err > bp::null);
-    std::stringstream ss;
-    std::string line;
-    while (curl.running() && std::getline(is, line) && !line.empty()) {
-        ss << line << '\n';
+}
+
+// Background tasks not finished yet; see HttpClient::exit
+std::atomic<int> runningTasks{0};
+
+// Run `task` in a detached thread. The returned future is ready when it finishes; the caller may
+// stop waiting for it at any time, but must then leave through HttpClient::exit.
+template <typename F>
+auto runInBackground(F task) {
+    using R = std::invoke_result_t<F>;
+    auto promise{std::make_shared<std::promise<R>>()};
+    auto future{promise->get_future()};
+    runningTasks++;
+    std::thread([promise, task{std::move(task)}]() mutable {
+        std::optional<R> result;
+        std::exception_ptr error;
+        try {
+            result.emplace(task());
+        } catch (...) {
+            error = std::current_exception();
+        }
+        runningTasks--;
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(*result));
+        }
+    }).detach();
+    return future;
+}
+
+std::size_t countLines(const boost::filesystem::path& path) {
+    boost::nowide::ifstream ifs(path.string());
+    std::size_t count{0};
+    for (std::string line; std::getline(ifs, line);) {
+        if (!line.empty()) count++;
     }
-    curl.wait();
-    if (curl.exit_code() != 0) {
-        return std::nullopt;
-    } else {
-        return ss.str();
+    return count;
+}
+
+// Lock file beside `path` (created if missing)
+boost::interprocess::file_lock lockFor(const boost::filesystem::path& path, const char* suffix) {
+    auto lockPath{boost::filesystem::path(path).concat(suffix)};
+    boost::nowide::ofstream(lockPath.string(), std::ios::app);
+    return boost::interprocess::file_lock(lockPath.string().c_str());
+}
+
+// Appending to the spool and moving hits out of it happen under `<spool>.lock`, held only briefly
+constexpr auto SPOOL_LOCK_TIMEOUT{1s};
+
+boost::posix_time::ptime spoolLockDeadline() {
+    return boost::posix_time::microsec_clock::universal_time() +
+           boost::posix_time::milliseconds(SPOOL_LOCK_TIMEOUT.count() * 1000);
+}
+
+void appendHit(const boost::filesystem::path& spool) {
+    namespace ip = boost::interprocess;
+    auto append{[&] {
+        boost::nowide::ofstream(spool.string(), std::ios::app)
+            << std::chrono::system_clock::now().time_since_epoch().count() << '\n';
+    }};
+    try {
+        auto lock{lockFor(spool, ".lock")};
+        ip::scoped_lock guard(lock, spoolLockDeadline());
+        if (guard) {
+            append();
+            return;
+        }
+        LOG_DBG("Timed out locking ", spool);
+    } catch (const ip::interprocess_exception& e) {
+        LOG_DBG("Cannot lock ", spool, ": ", e.what());
     }
-#endif
+    // Better a hit which might be lost than none at all
+    append();
 }
 
+// Send all hits in the spool with one request. A claimed batch (`.sending`) left by an interrupted
+// run is sent again together with the new hits. Only one process at a time claims, sends and
+// removes a batch (under `<spool>.sending.lock`); the others leave their hits in the spool for a
+// later run.
+bool flushAnalytics(const boost::filesystem::path& spool) {
+    namespace fs = boost::filesystem;
+    namespace ip = boost::interprocess;
+    boost::system::error_code ec;
+    auto sendLock{lockFor(spool, ".sending.lock")};
+    ip::scoped_lock sendGuard(sendLock, ip::try_to_lock);
+    if (!sendGuard) {
+        LOG_DBG("Another process is sending analytics");
+        return false;
+    }
+    auto sending{fs::path(spool).concat(".sending")};
+    {
+        auto spoolLock{lockFor(spool, ".lock")};
+        ip::scoped_lock guard(spoolLock, spoolLockDeadline());
+        if (!guard) return false;
+        if (fs::exists(spool)) {
+            if (fs::exists(sending)) {
+                std::string pending;
+                fs::load_string_file(spool, pending);
+                boost::nowide::ofstream(sending.string(), std::ios::app) << pending;
+                fs::remove(spool, ec);
+            } else {
+                fs::rename(spool, sending, ec);
+                if (ec) return false;
+            }
+        }
+    }
+    auto count{countLines(sending)};
+    if (count == 0) return true;
+    auto path{"/update/"s + ANALYTICS_KEY + "?amount=" + std::to_string(count)};
+    if (!download(ANALYTICS_HOST, path.c_str(), nullptr, true)) return false;
+    fs::remove(sending, ec);
+    LOG_DBG("Sent ", count, " analytics hit(s)");
+    return true;
+}
+
+// Release metadata is cached with its ETag, so that an unchanged release is not downloaded again
+// and costs only a 304 (which GitHub does not count against the rate limit)
+class ReleaseCache {
+    boost::filesystem::path path;
+    std::chrono::seconds ttl;
+    nlohmann::json cache;
+
+    static std::int64_t now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void load() {
+        try {
+            std::string content;
+            boost::filesystem::load_string_file(path, content);
+            cache = nlohmann::json::parse(content);
+        } catch (...) {
+            cache = nullptr;
+        }
+    }
+
+    void save() {
+        try {
+            auto tempPath{boost::filesystem::path(path).concat(".tmp")};
+            boost::filesystem::save_string_file(tempPath, cache.dump());
+            boost::filesystem::rename(tempPath, path);
+        } catch (...) {
+            LOG_DBG("Cannot save release cache ", path);
+        }
+    }
+
+    std::optional<std::string> fresh() const {
+        if (!cache.is_object()) return std::nullopt;
+        auto fetchedAt{cache.value("FetchedAt", std::int64_t{0})};
+        if (now() - fetchedAt >= ttl.count()) return std::nullopt;
+        return cache.value("Body", "");
+    }
+
+    std::optional<std::string> fetch() {
+        httplib::Client client(RELEASE_HOST);
+        client.set_connection_timeout(BACKGROUND_CONNECT_TIMEOUT);
+        client.set_read_timeout(BACKGROUND_READ_TIMEOUT);
+        httplib::Headers headers;
+        if (cache.is_object() && !cache.value("ETag", "").empty()) {
+            headers.emplace("If-None-Match", cache.value("ETag", ""));
+        }
+        auto res{client.Get(RELEASE_PATH, headers)};
+        if (res && res->status == 304 && cache.is_object()) {
+            LOG_DBG("Release metadata not modified");
+            cache["FetchedAt"] = now();
+            save();
+            return cache.value("Body", "");
+        }
+        if (res && res->status == 200) {
+            cache = {{"ETag", res->get_header_value("ETag")},
+                     {"FetchedAt", now()},
+                     {"Body", res->body}};
+            save();
+            return res->body;
+        }
+        LOG_DBG("Fetch release metadata failed: status ", res ? res->status : -1);
+        // Better late than nothing
+        if (cache.is_object()) return cache.value("Body", "");
+        return std::nullopt;
+    }
+
+public:
+    ReleaseCache(const boost::filesystem::path& path, std::chrono::seconds ttl)
+        : path(path), ttl(ttl) {}
+
+    std::optional<std::string> get() {
+        load();
+        if (auto body{fresh()}) return body;
+        // Other instances on this machine wait for the one fetching, then reuse its result
+        namespace ip = boost::interprocess;
+        auto lockPath{boost::filesystem::path(path).concat(".lock")};
+        try {
+            boost::nowide::ofstream(lockPath.string(), std::ios::app);
+            ip::file_lock lock(lockPath.string().c_str());
+            ip::scoped_lock guard(lock, boost::posix_time::microsec_clock::universal_time() +
+                                            boost::posix_time::seconds(UPDATE_DEADLINE.count()));
+            if (guard) {
+                load();
+                if (auto body{fresh()}) return body;
+                return fetch();
+            }
+        } catch (const ip::interprocess_exception& e) {
+            LOG_DBG("Cannot lock ", lockPath, ": ", e.what());
+        }
+        return fetch();
+    }
+};
+
 }  // namespace
 
 namespace Cli {
     
 void checkUpdate() {
-    auto data{download("https://api.github.com",
-                       "/repos/Guyutongxue/VSCodeConfigHelper3/releases/latest")};
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+    LOG_ERR("此构建未启用 HTTPS 支持，无法检查更新。请使用启用 TLS 的构建。");
+    return;
+#endif
+    auto cacheDir{Native::getAppdata() / "vscch"};
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(cacheDir, ec);
+    auto request{runInBackground([path = cacheDir / "release.json"] {
+        return ReleaseCache(path, std::chrono::minutes(std::max(options.UpdateCacheTtl, 0))).get();
+    })};
+    if (request.wait_for(UPDATE_DEADLINE) != std::future_status::ready) {
+        LOG_ERR("获取最新版本信息超时。");
+        return;
+    }
+    auto data{request.get()};
     if (!data) {
         LOG_ERR("无法获取最新版本信息。");
         return;
@@ -107,12 +401,86 @@ void checkUpdate() {
 
 }  // namespace Cli
 
-void Generator::sendAnalytics() {
-    auto data{download("https://api.countapi.xyz",
-                       "/hit/guyutongxue.github.io/b54f2252-e54a-4bd0-b4c2-33b47db6aa98")};
-    if (data) {
+namespace HttpClient {
+
+int fetchCommand(int argc, char** argv) {
+    namespace po = boost::program_options;
+    std::string url, savePath;
+    // clang-format off
+    po::options_description desc("fetch Options", 79);
+    desc.add_options()
+        ("url", po::value(&url), "下载地址")
+        ("output,o", po::value(&savePath), "保存路径，默认输出到标准输出")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("url", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || url.empty()) {
+        std::cout << "用法：vscch3 fetch <url> [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    auto scheme{url.find("://")};
+    auto slash{url.find('/', scheme == std::string::npos ? 0 : scheme + 3)};
+    if (scheme == std::string::npos || slash == std::string::npos) {
+        LOG_ERR(url, " 不是有效的地址。");
+        return 1;
+    }
+    auto host{url.substr(0, slash)};
+    auto path{url.substr(slash)};
+    auto result{
+        download(host.c_str(), path.c_str(), savePath.empty() ? nullptr : savePath.c_str())};
+    if (!result) {
+        LOG_ERR("下载 ", url, " 失败。");
+        return 1;
+    }
+    std::cout << *result;
+    return 0;
+}
+
+void exit(int exitCode) {
+    if (runningTasks == 0) std::exit(exitCode);
+    LOG_DBG(runningTasks.load(), " background request(s) still running, skip cleanup");
+    std::cout.flush();
+    std::fflush(nullptr);
+    std::_Exit(exitCode);
+}
+
+}  // namespace HttpClient
+
+std::future<bool> Generator::sendAnalytics() {
+    namespace fs = boost::filesystem;
+    // Record the hit locally first, so that it is sent by a later run if the network is slow now
+    auto spool{cacheDirectory() / "analytics.spool"};
+    try {
+        fs::create_directories(spool.parent_path());
+        appendHit(spool);
+    } catch (...) {
+        LOG_DBG("Cannot write analytics spool ", spool);
+    }
+    return runInBackground([spool] {
+        try {
+            return flushAnalytics(spool);
+        } catch (...) {
+            return false;
+        }
+    });
+}
+
+void Generator::waitAnalytics(std::future<bool>& analytics) {
+    if (!analytics.valid()) return;
+    if (analytics.wait_for(ANALYTICS_DEADLINE) == std::future_status::ready && analytics.get()) {
         LOG_INF("统计数据发送成功。");
     } else {
-        LOG_WRN("统计数据发送失败。");
+        LOG_DBG("Analytics not sent, will retry in a later run");
     }
 }
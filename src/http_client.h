@@ -0,0 +1,29 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+namespace HttpClient {
+
+// Subcommand `fetch`: download one URL with the client used for update checks and analytics
+int fetchCommand(int argc, char** argv);
+
+// Like std::exit. But if a background request outlived the wait for it, end the process without
+// running static destructors (of the logger, OpenSSL...), which that request may still use.
+[[noreturn]] void exit(int exitCode);
+
+}  // namespace HttpClient
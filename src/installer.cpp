@@ -0,0 +1,594 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "installer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/algorithm/string.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/process.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "downloader.h"
+#include "log.h"
+#include "native.h"
+
+#ifndef WINDOWS
+#include <csignal>
+#endif
+
+namespace Installer {
+
+namespace bp = boost::process;
+namespace fs = boost::filesystem;
+
+namespace {
+
+// Memory held between stages, so that a slow stage blocks the faster ones instead of buffering
+// the whole archive
+constexpr std::size_t DOWNLOAD_BUFFER_SIZE{16 << 20};
+constexpr std::size_t WRITE_BUFFER_SIZE{64 << 20};
+constexpr std::size_t BLOCK_SIZE{512};
+
+// A queue whose total weight (bytes) is limited. The producer calls `close` when it is done; any
+// stage calls `abort` to stop everyone.
+template <typename T>
+class BoundedQueue {
+    std::mutex mutex;
+    std::condition_variable notFull, notEmpty;
+    std::deque<std::pair<T, std::size_t>> items;
+    std::size_t used{0};
+    std::size_t capacity;
+    bool closed{false};
+    bool aborted{false};
+
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity(capacity) {}
+
+    bool push(T item, std::size_t weight) {
+        std::unique_lock lock(mutex);
+        // An item larger than the capacity is still accepted when the queue is empty
+        notFull.wait(lock, [&] { return aborted || used == 0 || used + weight <= capacity; });
+        if (aborted) return false;
+        used += weight;
+        items.emplace_back(std::move(item), weight);
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns nullopt when closed and drained, or aborted
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex);
+        notEmpty.wait(lock, [&] { return aborted || closed || !items.empty(); });
+        if (aborted || items.empty()) return std::nullopt;
+        auto [item, weight]{std::move(items.front())};
+        items.pop_front();
+        used -= weight;
+        notFull.notify_all();
+        return std::move(item);
+    }
+
+    void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+    void abort() {
+        std::lock_guard lock(mutex);
+        aborted = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+enum class ArchiveType { Tar, TarGz, TarBz2, TarXz, TarZst, SevenZip, Zip };
+
+std::optional<ArchiveType> archiveType(const std::string& url) {
+    auto name{boost::to_lower_copy(url.substr(0, url.find('?')))};
+    auto is{[&](const char* ext) { return boost::ends_with(name, ext); }};
+    if (is(".tar")) return ArchiveType::Tar;
+    if (is(".tar.gz") || is(".tgz")) return ArchiveType::TarGz;
+    if (is(".tar.bz2") || is(".tbz2")) return ArchiveType::TarBz2;
+    if (is(".tar.xz") || is(".txz")) return ArchiveType::TarXz;
+    if (is(".tar.zst") || is(".tzst")) return ArchiveType::TarZst;
+    if (is(".7z")) return ArchiveType::SevenZip;
+    if (is(".zip")) return ArchiveType::Zip;
+    return std::nullopt;
+}
+
+const char* decompressorName(ArchiveType type) {
+    switch (type) {
+        case ArchiveType::TarGz: return "gzip";
+        case ArchiveType::TarBz2: return "bzip2";
+        case ArchiveType::TarXz: return "xz";
+        case ArchiveType::TarZst: return "zstd";
+        default: return nullptr;
+    }
+}
+
+fs::path find7z() {
+    for (const char* name : {"7z", "7za", "7zz"}) {
+        auto path{bp::search_path(name)};
+        if (!path.empty()) return path;
+    }
+#ifdef WINDOWS
+    fs::path installed{"C:\\Program Files\\7-Zip\\7z.exe"};
+    if (fs::exists(installed)) return installed;
+#endif
+    return {};
+}
+
+// Relative path inside the target folder; nullopt for absolute paths and those escaping by ".."
+std::optional<fs::path> safeRelative(const std::string& name) {
+    fs::path result;
+    for (const auto& part : fs::path(name)) {
+        if (part == "." || part == "/" || part.empty()) continue;
+        if (part == ".." || part.has_root_name()) return std::nullopt;
+        result /= part;
+    }
+    if (result.empty()) return std::nullopt;
+    return result;
+}
+
+// Whether a symlink at `dir / link` pointing to `target` resolves inside `dir`. The target must be
+// relative with ".." only at its beginning (not climbing above `dir`), and the link's own folder
+// must be reached without symlinks. Then, by induction, every accepted link resolves to a real
+// folder inside `dir` followed by names inside it.
+bool safeLinkTarget(const fs::path& dir, const fs::path& link, const std::string& target) {
+    fs::path targetPath(target);
+    if (target.empty() || targetPath.has_root_path()) return false;
+    std::size_t depth{0};
+    auto folder{dir};
+    for (const auto& part : link.parent_path()) {
+        folder /= part;
+        boost::system::error_code ec;
+        if (fs::is_symlink(fs::symlink_status(folder, ec))) return false;
+        depth++;
+    }
+    bool descending{false};
+    for (const auto& part : targetPath) {
+        if (part == "." || part.empty()) continue;
+        if (part == "..") {
+            if (descending || depth == 0) return false;
+            depth--;
+        } else {
+            descending = true;
+        }
+    }
+    return true;
+}
+
+struct FileJob {
+    fs::path path;
+    std::string content;
+    unsigned mode;
+};
+
+// Streaming reader of ustar archives, with GNU long names and pax paths
+class TarReader {
+    std::function<std::size_t(char*, std::size_t)> read;
+
+    bool readExact(char* buffer, std::size_t size) {
+        while (size > 0) {
+            auto n{read(buffer, size)};
+            if (n == 0) return false;
+            buffer += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static std::string field(const char* data, std::size_t size) {
+        return std::string(data, strnlen(data, size));
+    }
+
+    static std::uint64_t number(const char* data, std::size_t size) {
+        std::uint64_t value{0};
+        // Base-256, used by GNU tar for large sizes
+        if (static_cast<unsigned char>(data[0]) & 0x80) {
+            value = static_cast<unsigned char>(data[0]) & 0x7f;
+            for (std::size_t i{1}; i < size; i++) {
+                value = (value << 8) | static_cast<unsigned char>(data[i]);
+            }
+            return value;
+        }
+        for (std::size_t i{0}; i < size && data[i] != '\0'; i++) {
+            if (data[i] >= '0' && data[i] <= '7') value = value * 8 + (data[i] - '0');
+        }
+        return value;
+    }
+
+    static void parsePax(const std::string& records, std::string& path, std::string& linkPath) {
+        std::size_t pos{0};
+        while (pos < records.size()) {
+            auto space{records.find(' ', pos)};
+            if (space == std::string::npos) break;
+            std::size_t length{0};
+            try {
+                length = std::stoull(records.substr(pos, space - pos));
+            } catch (...) {
+                break;
+            }
+            if (length == 0 || pos + length > records.size()) break;
+            auto record{records.substr(space + 1, pos + length - space - 2)};
+            auto eq{record.find('=')};
+            if (eq != std::string::npos) {
+                auto key{record.substr(0, eq)};
+                if (key == "path") path = record.substr(eq + 1);
+                if (key == "linkpath") linkPath = record.substr(eq + 1);
+            }
+            pos += length;
+        }
+    }
+
+public:
+    struct Entry {
+        char type;
+        std::string name;
+        std::string linkName;
+        std::uint64_t size;
+        unsigned mode;
+    };
+
+    explicit TarReader(std::function<std::size_t(char*, std::size_t)> read)
+        : read(std::move(read)) {}
+
+    // Returns nullopt at the end of the archive; throws on a truncated or malformed one. The
+    // content of a returned entry must be consumed by `readContent` or `skipContent`.
+    std::optional<Entry> next() {
+        std::string longName, longLink;
+        while (true) {
+            char header[BLOCK_SIZE];
+            if (!readExact(header, BLOCK_SIZE)) {
+                throw std::runtime_error("archive is truncated");
+            }
+            if (std::all_of(header, header + BLOCK_SIZE, [](char c) { return c == '\0'; })) {
+                return std::nullopt;
+            }
+            Entry entry{header[156], field(header, 100), field(header + 157, 100),
+                        number(header + 124, 12),
+                        static_cast<unsigned>(number(header + 100, 8))};
+            if (std::memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+                entry.name = field(header + 345, 155) + "/" + entry.name;
+            }
+            if (entry.type == 'L' || entry.type == 'K' || entry.type == 'x') {
+                auto content{readContent(entry.size)};
+                if (entry.type == 'L') {
+                    longName = field(content.data(), content.size());
+                } else if (entry.type == 'K') {
+                    longLink = field(content.data(), content.size());
+                } else {
+                    parsePax(content, longName, longLink);
+                }
+                continue;
+            }
+            if (entry.type == 'g') {
+                skipContent(entry.size);
+                continue;
+            }
+            if (!longName.empty()) entry.name = longName;
+            if (!longLink.empty()) entry.linkName = longLink;
+            return entry;
+        }
+    }
+
+    std::string readContent(std::uint64_t size) {
+        std::string content(size, '\0');
+        if (!readExact(content.data(), size)) {
+            throw std::runtime_error("archive is truncated");
+        }
+        skipPadding(size);
+        return content;
+    }
+
+    void skipContent(std::uint64_t size) {
+        char buffer[BLOCK_SIZE * 16];
+        auto remain{size};
+        while (remain > 0) {
+            auto n{std::min<std::uint64_t>(remain, sizeof(buffer))};
+            if (!readExact(buffer, n)) throw std::runtime_error("archive is truncated");
+            remain -= n;
+        }
+        skipPadding(size);
+    }
+
+    void skipPadding(std::uint64_t size) {
+        char buffer[BLOCK_SIZE];
+        auto padding{(BLOCK_SIZE - size % BLOCK_SIZE) % BLOCK_SIZE};
+        if (!readExact(buffer, padding)) throw std::runtime_error("archive is truncated");
+    }
+};
+
+bool writeFile(const FileJob& job) {
+    boost::system::error_code ec;
+    fs::create_directories(job.path.parent_path(), ec);
+    // fopen would follow a symlink left here by a previous install
+    fs::remove(job.path, ec);
+    std::FILE* file{boost::nowide::fopen(job.path.string().c_str(), "wb")};
+    if (!file) return false;
+    bool ok{std::fwrite(job.content.data(), 1, job.content.size(), file) == job.content.size()};
+    ok = std::fclose(file) == 0 && ok;
+#ifndef WINDOWS
+    fs::permissions(job.path, static_cast<fs::perms>(job.mode & 0777), ec);
+#endif
+    return ok;
+}
+
+// download -> (decompressor process) -> tar parser -> writer threads
+bool extractTarStream(const std::string& url, ArchiveType type, const fs::path& dir) {
+    fs::path decompressor;
+    if (auto name{decompressorName(type)}) {
+        decompressor = bp::search_path(name);
+        if (decompressor.empty()) {
+            LOG_ERR("未找到解压工具 ", name, "，请安装后重试。");
+            return false;
+        }
+    }
+#ifndef WINDOWS
+    // Writing to a decompressor which has exited should fail rather than kill us
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    std::atomic_bool failed{false};
+    BoundedQueue<std::string> compressed(DOWNLOAD_BUFFER_SIZE);
+    BoundedQueue<FileJob> files(WRITE_BUFFER_SIZE);
+    std::optional<bp::child> proc;
+    auto fail{[&](const std::string& message) {
+        if (!failed.exchange(true)) {
+            LOG_ERR(message);
+        }
+        compressed.abort();
+        files.abort();
+    }};
+
+    std::thread downloader([&] {
+        if (Downloader::fetch(url, [&](const char* data, std::size_t length) {
+                return compressed.push(std::string(data, length), length);
+            })) {
+            compressed.close();
+        } else {
+            fail("下载 " + url + " 失败。");
+        }
+    });
+
+    std::vector<std::thread> writers;
+    std::atomic_size_t fileCount{0};
+    auto writerCount{std::clamp(std::thread::hardware_concurrency(), 2u, 8u)};
+    for (unsigned i{0}; i < writerCount; i++) {
+        writers.emplace_back([&] {
+            while (auto job{files.pop()}) {
+                if (!writeFile(*job)) {
+                    fail("无法写入文件 " + job->path.string() + "。");
+                    return;
+                }
+                fileCount++;
+            }
+        });
+    }
+
+    bp::opstream toProc;
+    bp::ipstream fromProc;
+    std::thread feeder;
+    std::function<std::size_t(char*, std::size_t)> read;
+    if (decompressor.empty()) {
+        // Plain tar: parse the downloaded blocks directly
+        read = [&, block = std::string(), offset = std::size_t{0}](char* buffer,
+                                                                    std::size_t size) mutable {
+            while (offset == block.size()) {
+                auto next{compressed.pop()};
+                if (!next) return std::size_t{0};
+                block = std::move(*next);
+                offset = 0;
+            }
+            auto n{std::min(size, block.size() - offset)};
+            std::memcpy(buffer, block.data() + offset, n);
+            offset += n;
+            return n;
+        };
+    } else {
+        proc.emplace(decompressor, "-dc", bp::std_in < toProc, bp::std_out > fromProc,
+                     bp::std_err > bp::null);
+        feeder = std::thread([&] {
+            while (auto block{compressed.pop()}) {
+                if (!toProc.write(block->data(), block->size())) {
+                    fail("解压失败。");
+                    break;
+                }
+            }
+            toProc.flush();
+            toProc.pipe().close();
+        });
+        read = [&](char* buffer, std::size_t size) {
+            fromProc.read(buffer, size);
+            return static_cast<std::size_t>(fromProc.gcount());
+        };
+    }
+
+    // Links are created after all files are written, since their targets may come later. Symlinks
+    // are kept relative to `dir`, to be checked then.
+    std::vector<std::pair<fs::path, std::string>> symlinks;
+    std::vector<std::pair<fs::path, fs::path>> hardlinks;
+    try {
+        TarReader reader(read);
+        while (auto entry{reader.next()}) {
+            auto path{safeRelative(entry->name)};
+            if (!path) {
+                LOG_WRN("跳过不安全的路径 ", entry->name, "。");
+                reader.skipContent(entry->size);
+                continue;
+            }
+            switch (entry->type) {
+                case '0':
+                case '\0':
+                case '7': {
+                    auto size{entry->size};
+                    FileJob job{dir / *path, reader.readContent(size), entry->mode};
+                    if (!files.push(std::move(job), size)) throw std::runtime_error("aborted");
+                    break;
+                }
+                case '5': fs::create_directories(dir / *path); break;
+                case '2': symlinks.emplace_back(*path, entry->linkName); break;
+                case '1': {
+                    auto target{safeRelative(entry->linkName)};
+                    if (target) hardlinks.emplace_back(dir / *path, dir / *target);
+                    break;
+                }
+                default: reader.skipContent(entry->size); break;
+            }
+            if (failed) break;
+        }
+        // Let the decompressor finish the trailing padding
+        char buffer[BLOCK_SIZE * 16];
+        while (read(buffer, sizeof(buffer)) > 0) {
+        }
+    } catch (const std::exception& e) {
+        fail("解析压缩包失败：" + std::string(e.what()));
+        if (proc) {
+            std::error_code ec;
+            proc->terminate(ec);
+        }
+    }
+    files.close();
+    downloader.join();
+    if (feeder.joinable()) feeder.join();
+    for (auto& t : writers) {
+        t.join();
+    }
+    if (proc) {
+        std::error_code ec;
+        proc->wait(ec);
+        if (!failed && proc->exit_code() != 0) {
+            fail("解压工具 " + decompressor.string() + " 返回了 " +
+                 std::to_string(proc->exit_code()) + "。");
+        }
+    }
+    if (failed) return false;
+
+    for (const auto& [link, target] : hardlinks) {
+        boost::system::error_code ec;
+        fs::remove(link, ec);
+        fs::copy_file(target, link, ec);
+        if (ec) LOG_WRN("无法创建链接 ", link, "：", ec.message());
+    }
+    for (const auto& [link, target] : symlinks) {
+        if (!safeLinkTarget(dir, link, target)) {
+            LOG_WRN("跳过指向目标文件夹之外的链接 ", link, " -> ", target, "。");
+            continue;
+        }
+        boost::system::error_code ec;
+        fs::remove(dir / link, ec);
+        fs::create_symlink(target, dir / link, ec);
+        if (ec) LOG_WRN("无法创建链接 ", dir / link, "：", ec.message());
+    }
+    LOG_INF("已解压 ", fileCount.load(), " 个文件。");
+    return true;
+}
+
+// 7z and zip archives cannot be read as a stream, so the archive is downloaded first (in parallel
+// ranges) and extracted by multi-threaded 7-Zip
+bool extractWith7z(const std::vector<std::string>& mirrors, const fs::path& dir) {
+    auto sevenZip{find7z()};
+    if (sevenZip.empty()) {
+        LOG_ERR("未找到 7-Zip，请安装后重试。");
+        return false;
+    }
+    auto url{mirrors.front()};
+    auto archive{dir.parent_path() /
+                 fs::path(url.substr(0, url.find('?'))).filename().concat(".download")};
+    Downloader::DownloadOptions options;
+    options.Mirrors = mirrors;
+    options.SavePath = archive;
+    options.Connections = std::clamp(std::thread::hardware_concurrency(), 2u, 8u);
+    if (!Downloader::download(options)) return false;
+    int result{bp::system(sevenZip, "x", "-y", "-mmt=on", "-o" + dir.string(), archive,
+                          bp::std_out > bp::null)};
+    boost::system::error_code ec;
+    fs::remove(archive, ec);
+    if (result != 0) {
+        LOG_ERR("7-Zip 解压失败，返回值为 ", result, "。");
+        return false;
+    }
+    return true;
+}
+
+// The archive usually has a single top level folder, so look one level deeper too
+std::optional<fs::path> findBin(const fs::path& dir) {
+    auto hasCompiler{[](const fs::path& bin) {
+        for (const char* name : {"g++", "clang++"}) {
+#ifdef WINDOWS
+            if (fs::exists(bin / (std::string(name) + ".exe"))) return true;
+#else
+            if (fs::exists(bin / name)) return true;
+#endif
+        }
+        return false;
+    }};
+    if (hasCompiler(dir / "bin")) return dir / "bin";
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (fs::is_directory(entry) && hasCompiler(entry.path() / "bin")) {
+            return entry.path() / "bin";
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+std::optional<fs::path> installToolchain(const std::vector<std::string>& mirrors,
+                                         const fs::path& dir) {
+    if (mirrors.empty()) return std::nullopt;
+    auto type{archiveType(mirrors.front())};
+    if (!type) {
+        LOG_ERR("无法从地址 ", mirrors.front(),
+                " 判断压缩包格式。支持 .tar、.tar.gz、.tar.bz2、.tar.xz、.tar.zst、.7z 与 .zip。");
+        return std::nullopt;
+    }
+    fs::create_directories(dir);
+    LOG_INF("安装工具链到 ", dir, "...");
+    bool ok{false};
+    if (*type == ArchiveType::SevenZip || *type == ArchiveType::Zip) {
+        ok = extractWith7z(mirrors, dir);
+    } else {
+        auto index{mirrors.size() == 1 ? std::optional<std::size_t>{0}
+                                       : Downloader::fastestMirror(mirrors)};
+        if (!index) {
+            LOG_ERR("所有镜像均无法访问。");
+            return std::nullopt;
+        }
+        LOG_INF("从 ", mirrors[*index], " 下载并解压...");
+        ok = extractTarStream(mirrors[*index], *type, dir);
+    }
+    if (!ok) return std::nullopt;
+    auto bin{findBin(dir)};
+    if (!bin) {
+        LOG_ERR("在 ", dir, " 中未找到编译器。");
+        return std::nullopt;
+    }
+    LOG_INF("工具链已安装，编译器位于 ", *bin, "。");
+    return bin;
+}
+
+}  // namespace Installer
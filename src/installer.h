@@ -0,0 +1,35 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Install a MinGW / portable GCC bundle from an archive on the Internet. Downloading, decompressing
+// and writing files run concurrently.
+
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Installer {
+
+// Download the archive (from the fastest of `mirrors`) and extract it into `dir`. Returns the
+// `bin` folder which contains the compiler.
+std::optional<boost::filesystem::path> installToolchain(const std::vector<std::string>& mirrors,
+                                                        const boost::filesystem::path& dir);
+
+}  // namespace Installer
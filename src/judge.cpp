@@ -0,0 +1,380 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "judge.h"
+
+#include "native.h"
+
+#ifndef WINDOWS
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef MACOS
+#include <libproc.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#endif
+
+#include <iostream>
+
+#include "log.h"
+
+namespace Judge {
+
+#ifdef WINDOWS
+
+int judgeCommand(int, char**) {
+    LOG_ERR("评测功能暂不支持 Windows。");
+    return 1;
+}
+
+#else
+
+using namespace std::literals;
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace {
+
+enum class Verdict { AC, WA, TLE, MLE, RE };
+
+const char* VERDICT_NAMES[]{"AC", "WA", "TLE", "MLE", "RE"};
+
+struct Limits {
+    long timeMs;
+    long memoryMiB;
+};
+
+struct CaseResult {
+    Verdict verdict{Verdict::AC};
+    double timeMs{0};
+    double memoryMiB{0};
+    std::string message;
+};
+
+// Anonymous temporary file which is not inherited by the children other workers fork meanwhile
+std::FILE* tmpFile() {
+    int fd{-1};
+#ifdef O_TMPFILE
+    fd = open(fs::temp_directory_path().c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+    if (fd < 0) {
+        auto path{(fs::temp_directory_path() / "vscch-judge-XXXXXX").string()};
+        fd = mkostemp(path.data(), O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        unlink(path.c_str());
+    }
+    auto file{fdopen(fd, "w+")};
+    if (!file) close(fd);
+    return file;
+}
+
+// Compare names with digit runs as numbers, so that case 2 comes before case 10
+bool naturalLess(const std::string& a, const std::string& b) {
+    std::size_t i{0}, j{0};
+    while (i < a.size() && j < b.size()) {
+        if (std::isdigit(static_cast<unsigned char>(a[i])) &&
+            std::isdigit(static_cast<unsigned char>(b[j]))) {
+            auto endA{a.find_first_not_of("0123456789", i)};
+            auto endB{b.find_first_not_of("0123456789", j)};
+            endA = endA == std::string::npos ? a.size() : endA;
+            endB = endB == std::string::npos ? b.size() : endB;
+            auto numA{std::string_view(a).substr(i, endA - i)};
+            auto numB{std::string_view(b).substr(j, endB - j)};
+            numA.remove_prefix(std::min(numA.find_first_not_of('0'), numA.size()));
+            numB.remove_prefix(std::min(numB.find_first_not_of('0'), numB.size()));
+            if (numA.size() != numB.size()) return numA.size() < numB.size();
+            if (numA != numB) return numA < numB;
+            i = endA;
+            j = endB;
+        } else {
+            if (a[i] != b[j]) return a[i] < b[j];
+            i++;
+            j++;
+        }
+    }
+    return a.size() - i < b.size() - j;
+}
+
+std::string readAll(std::FILE* file) {
+    std::string content;
+    std::rewind(file);
+    char buf[65536];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) {
+        content.append(buf, n);
+    }
+    return content;
+}
+
+// Next line without trailing whitespace; returns false at the end of text
+bool nextLine(std::string_view& text, std::string_view& line) {
+    if (text.empty()) return false;
+    auto pos{text.find('\n')};
+    line = text.substr(0, pos);
+    text.remove_prefix(pos == std::string_view::npos ? text.size() : pos + 1);
+    auto end{line.find_last_not_of(" \t\r\f\v")};
+    line = end == std::string_view::npos ? std::string_view{} : line.substr(0, end + 1);
+    return true;
+}
+
+std::string_view trimTrailingSpace(std::string_view text) {
+    auto end{text.find_last_not_of(" \t\r\n\f\v")};
+    return end == std::string_view::npos ? std::string_view{} : text.substr(0, end + 1);
+}
+
+// Compare line by line, ignoring trailing whitespace of each line and trailing blank lines.
+// Returns the first different line number (1-based), or 0 if same.
+std::size_t compareOutput(std::string_view output, std::string_view answer) {
+    output = trimTrailingSpace(output);
+    answer = trimTrailingSpace(answer);
+    std::string_view outLine, ansLine;
+    for (std::size_t lineNo{1};; lineNo++) {
+        bool hasOut{nextLine(output, outLine)};
+        bool hasAns{nextLine(answer, ansLine)};
+        if (!hasOut && !hasAns) return 0;
+        if (hasOut != hasAns || outLine != ansLine) return lineNo;
+    }
+}
+
+CaseResult runCase(const std::string& program, const fs::path& input, const fs::path& answer,
+                   const Limits& limits) {
+    CaseResult result;
+    auto inputStr{input.string()};
+    std::FILE* output{tmpFile()};
+    std::FILE* error{tmpFile()};
+    if (!output || !error) {
+        if (output) std::fclose(output);
+        if (error) std::fclose(error);
+        return {Verdict::RE, 0, 0, "无法创建临时文件"};
+    }
+
+    auto pid{fork()};
+    if (pid == 0) {
+        int inFd{open(inputStr.c_str(), O_RDONLY)};
+        if (inFd < 0) _exit(127);
+        dup2(inFd, STDIN_FILENO);
+        close(inFd);
+        dup2(fileno(output), STDOUT_FILENO);
+        dup2(fileno(error), STDERR_FILENO);
+        // CPU time limit rounded up to seconds; the precise check is done with rusage
+        rlim_t cpuSeconds = (limits.timeMs + 999) / 1000 + 1;
+        rlimit cpu{cpuSeconds, cpuSeconds + 1};
+        setrlimit(RLIMIT_CPU, &cpu);
+#ifndef MACOS
+        // Not enforced by macOS; the parent watches the resident size there instead
+        rlim_t memoryBytes = static_cast<rlim_t>(limits.memoryMiB) << 20;
+        rlimit as{memoryBytes, memoryBytes};
+        setrlimit(RLIMIT_AS, &as);
+#endif
+        // Also stop programs blocked on I/O or sleeping (real timer survives exec)
+        long wallMs{limits.timeMs * 3 + 1000};
+        itimerval timer{{0, 0}, {wallMs / 1000, wallMs % 1000 * 1000}};
+        setitimer(ITIMER_REAL, &timer, nullptr);
+        execl(program.c_str(), program.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    if (pid < 0) {
+        std::fclose(output);
+        std::fclose(error);
+        return {Verdict::RE, 0, 0, "无法创建进程"s + std::strerror(errno)};
+    }
+    bool memoryKilled{false};
+#ifdef MACOS
+    std::atomic<bool> exited{false};
+    std::thread watcher([&] {
+        auto limitBytes{static_cast<std::uint64_t>(limits.memoryMiB) << 20};
+        while (!exited) {
+            rusage_info_v2 info{};
+            if (proc_pid_rusage(pid, RUSAGE_INFO_V2, reinterpret_cast<rusage_info_t*>(&info)) ==
+                    0 &&
+                info.ri_resident_size > limitBytes) {
+                memoryKilled = true;
+                kill(pid, SIGKILL);
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    // Stop watching before reaping, so that a reused pid is never killed
+    siginfo_t info;
+    while (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) < 0 && errno == EINTR) {
+    }
+    exited = true;
+    watcher.join();
+#endif
+    int status{0};
+    rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    result.timeMs = usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3 +
+                    usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3;
+#ifdef MACOS
+    result.memoryMiB = usage.ru_maxrss / 1048576.0;
+#else
+    result.memoryMiB = usage.ru_maxrss / 1024.0;
+#endif
+    auto outputStr{readAll(output)};
+    auto errorStr{readAll(error)};
+    std::fclose(output);
+    std::fclose(error);
+
+    bool signaled{WIFSIGNALED(status)};
+    int signal{signaled ? WTERMSIG(status) : 0};
+    bool failed{signaled || WEXITSTATUS(status) != 0};
+    // An allocation beyond RLIMIT_AS fails instead of growing RSS. In C++ the uncaught bad_alloc
+    // says so on stderr; a C program using the null pointer just crashes, which stays RE since
+    // nothing tells it apart from other crashes.
+    if (signal == SIGXCPU || signal == SIGALRM || result.timeMs > limits.timeMs) {
+        result.verdict = Verdict::TLE;
+    } else if (memoryKilled || result.memoryMiB > limits.memoryMiB ||
+               (failed && errorStr.find("std::bad_alloc") != std::string::npos)) {
+        result.verdict = Verdict::MLE;
+    } else if (signaled) {
+        result.verdict = Verdict::RE;
+        result.message = strsignal(signal);
+    } else if (failed) {
+        result.verdict = Verdict::RE;
+        result.message = "返回值 " + std::to_string(WEXITSTATUS(status));
+    } else {
+        std::string answerStr;
+        fs::load_string_file(answer, answerStr);
+        if (auto line{compareOutput(outputStr, answerStr)}) {
+            result.verdict = Verdict::WA;
+            result.message = "第 " + std::to_string(line) + " 行不同";
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+int judgeCommand(int argc, char** argv) {
+    std::string program, dir;
+    Limits limits;
+    unsigned jobs;
+    // clang-format off
+    po::options_description desc("judge Options", 79);
+    desc.add_options()
+        ("program", po::value(&program), "要评测的程序")
+        ("dir,d", po::value(&dir)->default_value("tests"), "测试数据文件夹，包含 *.in  与 *.ans  文件")
+        ("time-limit,t", po::value(&limits.timeMs)->default_value(1000), "每个测试点的 CPU  时间限制（毫秒）")
+        ("memory-limit,m", po::value(&limits.memoryMiB)->default_value(256), "每个测试点的内存限制（MiB）")
+        ("jobs,j", po::value(&jobs)->default_value(std::max(1u, std::thread::hardware_concurrency())), "同时评测的测试点数")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("program", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || program.empty()) {
+        std::cout << "用法：vscch3 judge <program> [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    program = fs::absolute(program).string();
+    if (!fs::exists(program)) {
+        LOG_ERR("程序 ", program, " 不存在。");
+        return 1;
+    }
+    if (!fs::is_directory(dir)) {
+        LOG_ERR("测试数据文件夹 ", dir, " 不存在。");
+        return 1;
+    }
+
+    std::vector<std::pair<fs::path, fs::path>> cases;
+    for (auto&& entry : fs::directory_iterator(dir)) {
+        auto input{entry.path()};
+        if (input.extension() != ".in") continue;
+        auto answer{fs::path(input).replace_extension(".ans")};
+        if (!fs::exists(answer)) {
+            LOG_WRN("测试点 ", input.stem(), " 缺少答案文件，已跳过。");
+            continue;
+        }
+        cases.emplace_back(input, answer);
+    }
+    if (cases.empty()) {
+        LOG_ERR("文件夹 ", dir, " 中没有测试点。");
+        return 1;
+    }
+    std::sort(cases.begin(), cases.end(), [](const auto& a, const auto& b) {
+        return naturalLess(a.first.stem().string(), b.first.stem().string());
+    });
+
+    std::vector<CaseResult> results(cases.size());
+    std::atomic_size_t next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i{0}; i < std::clamp<std::size_t>(jobs, 1, cases.size()); i++) {
+        workers.emplace_back([&] {
+            for (std::size_t j; (j = next++) < cases.size();) {
+                results[j] = runCase(program, cases[j].first, cases[j].second, limits);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::size_t accepted{0};
+    for (std::size_t i{0}; i < cases.size(); i++) {
+        const auto& r{results[i]};
+        accepted += r.verdict == Verdict::AC;
+        std::cout << (r.verdict == Verdict::AC ? "\033[0;32m" : "\033[0;31m") << std::left
+                  << std::setw(4) << VERDICT_NAMES[static_cast<int>(r.verdict)] << "\033[0m "
+                  << std::setw(16) << cases[i].first.stem().string() << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(6) << r.timeMs << " ms "
+                  << std::setprecision(1) << std::setw(8) << r.memoryMiB << " MiB";
+        if (!r.message.empty()) {
+            std::cout << "  " << r.message;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "通过 " << accepted << "/" << cases.size() << " 个测试点。" << std::endl;
+    return accepted == cases.size() ? 0 : 1;
+}
+
+#endif
+
+}  // namespace Judge
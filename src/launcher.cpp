@@ -0,0 +1,224 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "launcher.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <iomanip>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+
+#include "log.h"
+#include "native.h"
+
+namespace Launcher {
+
+namespace bp = boost::process;
+namespace po = boost::program_options;
+
+namespace {
+
+std::optional<LauncherInfo> find(decltype(LauncherInfo::launcherType) type) {
+    auto path{bp::search_path(type == LauncherInfo::Ccache ? "ccache" : "sccache")};
+    if (path.empty()) return std::nullopt;
+    return LauncherInfo{type, path.string()};
+}
+
+struct Stats {
+    long long hits{0};
+    long long misses{0};
+};
+
+// ccache 4.x `--print-stats` prints lines of "<key>\t<value>"
+std::optional<Stats> parseCcacheStats(const std::string& output) {
+    std::istringstream iss(output);
+    std::string line;
+    Stats stats;
+    bool found{false};
+    while (std::getline(iss, line)) {
+        std::vector<std::string> parts;
+        boost::split(parts, line, boost::is_any_of("\t"));
+        if (parts.size() != 2) continue;
+        try {
+            if (parts[0] == "direct_cache_hit" || parts[0] == "preprocessed_cache_hit") {
+                stats.hits += std::stoll(parts[1]);
+                found = true;
+            } else if (parts[0] == "cache_miss") {
+                stats.misses += std::stoll(parts[1]);
+                found = true;
+            }
+        } catch (...) {
+            continue;
+        }
+    }
+    if (!found) return std::nullopt;
+    return stats;
+}
+
+// sccache `--show-stats --stats-format=json` gives counts per language
+std::optional<Stats> parseSccacheStats(const std::string& output) {
+    try {
+        auto j(nlohmann::json::parse(output));
+        const auto& s{j.at("stats")};
+        Stats stats;
+        for (auto&& [_, count] : s.at("cache_hits").at("counts").items()) {
+            stats.hits += count.get<long long>();
+        }
+        for (auto&& [_, count] : s.at("cache_misses").at("counts").items()) {
+            stats.misses += count.get<long long>();
+        }
+        return stats;
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+std::optional<std::string> runLauncher(const LauncherInfo& launcher,
+                                       const std::vector<std::string>& args,
+                                       const std::string& cacheDir) {
+    auto env{environment(launcher, cacheDir, "", false)};
+    std::vector<std::string> argv{launcher.Path};
+    argv.insert(argv.end(), args.begin(), args.end());
+    auto result{Native::spawn({.Args = std::move(argv),
+                               .Env = {env.begin(), env.end()},
+                               .Stderr = Native::SpawnOptions::Stream::Null})};
+    if (!result) {
+        LOG_ERR("运行 ", launcher.Path, " 时失败。");
+        return std::nullopt;
+    }
+    if (result->ExitCode != 0) return std::nullopt;
+    return std::move(result->Output);
+}
+
+}  // namespace
+
+std::optional<LauncherInfo> detect(const std::string& name) {
+    if (name.empty() || name == "none") return std::nullopt;
+    std::optional<LauncherInfo> result;
+    if (name == "auto") {
+        result = find(LauncherInfo::Ccache);
+        if (!result) result = find(LauncherInfo::Sccache);
+    } else if (name == "ccache") {
+        result = find(LauncherInfo::Ccache);
+    } else if (name == "sccache") {
+        result = find(LauncherInfo::Sccache);
+    } else {
+        LOG_WRN(name, " 不是支持的编译缓存工具。可选值为 auto、ccache、sccache 或 none。");
+        return std::nullopt;
+    }
+    if (result) {
+        LOG_INF("使用编译缓存工具 ", result->Path, "。");
+    } else {
+        LOG_WRN("未找到编译缓存工具 ", name, "，将直接调用编译器。");
+    }
+    return result;
+}
+
+std::map<std::string, std::string> environment(const LauncherInfo& launcher,
+                                               const std::string& cacheDir,
+                                               const std::string& maxSize, bool usePch,
+                                               const std::string& baseDir) {
+    std::map<std::string, std::string> env;
+    if (launcher.launcherType == LauncherInfo::Ccache) {
+        if (!cacheDir.empty()) {
+            env["CCACHE_DIR"] = cacheDir;
+            // Let other users in the same group reuse the results
+            env["CCACHE_UMASK"] = "002";
+        }
+        if (!maxSize.empty()) {
+            env["CCACHE_MAXSIZE"] = maxSize;
+        }
+        if (!baseDir.empty()) {
+            // Files of different users live in different folders, so do not hash the absolute
+            // paths
+            env["CCACHE_BASEDIR"] = baseDir;
+            env["CCACHE_NOHASHDIR"] = "1";
+        }
+        if (usePch) {
+            env["CCACHE_SLOPPINESS"] = "pch_defines,time_macros,include_file_mtime";
+        }
+    } else {
+        if (!cacheDir.empty()) {
+            env["SCCACHE_DIR"] = cacheDir;
+        }
+        if (!maxSize.empty()) {
+            env["SCCACHE_CACHE_SIZE"] = maxSize;
+        }
+    }
+    return env;
+}
+
+int printStats(int argc, char** argv) {
+    std::string name, cacheDir;
+    // clang-format off
+    po::options_description desc("cache-stats Options", 79);
+    desc.add_options()
+        ("compiler-launcher", po::value(&name)->default_value("auto"), "编译缓存工具，可为 auto、ccache、sccache")
+        ("launcher-cache-dir", po::value(&cacheDir), "编译缓存所在的文件夹")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help")) {
+        desc.print(std::cout, 30);
+        return 0;
+    }
+    auto launcher{detect(name)};
+    if (!launcher) {
+        LOG_ERR("未找到编译缓存工具。");
+        return 1;
+    }
+    std::optional<Stats> stats;
+    if (launcher->launcherType == LauncherInfo::Ccache) {
+        if (auto output{runLauncher(*launcher, {"--print-stats"}, cacheDir)}) {
+            stats = parseCcacheStats(*output);
+        } else if (auto output{runLauncher(*launcher, {"--show-stats"}, cacheDir)}) {
+            // ccache 3.x has no machine readable statistics
+            std::cout << *output;
+            return 0;
+        }
+    } else {
+        if (auto output{runLauncher(*launcher, {"--show-stats", "--stats-format=json"}, cacheDir)}) {
+            stats = parseSccacheStats(*output);
+        }
+    }
+    if (!stats) {
+        LOG_ERR("无法获取编译缓存统计信息。");
+        return 1;
+    }
+    auto total{stats->hits + stats->misses};
+    std::cout << "编译缓存工具：" << launcher->Path << std::endl;
+    std::cout << "命中 " << stats->hits << " 次，未命中 " << stats->misses << " 次";
+    if (total > 0) {
+        std::cout << "，命中率 " << std::fixed << std::setprecision(1)
+                  << 100.0 * stats->hits / total << "%";
+    }
+    std::cout << "。" << std::endl;
+    return 0;
+}
+
+}  // namespace Launcher
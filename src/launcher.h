@@ -0,0 +1,47 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+// Compiler launchers (ccache, sccache) which cache compilation results
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+
+namespace Launcher {
+
+struct LauncherInfo {
+    enum { Ccache, Sccache } launcherType;
+
+    std::string Path;
+};
+
+// `name` may be "auto", "ccache", "sccache" or "none" (or empty, the same as "none")
+std::optional<LauncherInfo> detect(const std::string& name);
+
+// Environment variables which make the launcher use the given (possibly shared) cache directory.
+// `baseDir` is where paths are made relative from (ccache only), omitted if empty.
+std::map<std::string, std::string> environment(const LauncherInfo& launcher,
+                                               const std::string& cacheDir,
+                                               const std::string& maxSize, bool usePch,
+                                               const std::string& baseDir = "");
+
+// Subcommand `cache-stats`
+int printStats(int argc, char** argv);
+
+}  // namespace Launcher
@@ -17,15 +17,40 @@
 
 #include "log.h"
 
+#include <zlib.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifndef WINDOWS
+#include <sys/stat.h>
+#endif
+
+#ifdef VSCCH_LEAN
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#else
 #include <boost/locale/generator.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/basic_sink_backend.hpp>
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/utility/setup.hpp>
-#include <iostream>
+#endif
 
 namespace Log {
 
+#ifndef VSCCH_LEAN
 namespace logging = boost::log;
 namespace trivial = boost::log::trivial;
 namespace sinks = boost::log::sinks;
@@ -33,11 +58,230 @@ namespace attrs = boost::log::attributes;
 namespace src = boost::log::sources;
 namespace expr = boost::log::expressions;
 namespace keywords = boost::log::keywords;
+#endif
 
 namespace {
 
+namespace fs = boost::filesystem;
+namespace ip = boost::interprocess;
+
+// The log file is rotated when it grows over this size. At most this many old segments are kept,
+// gzipped.
+constexpr std::uintmax_t MAX_LOG_SIZE{1 << 20};
+constexpr int MAX_LOG_SEGMENTS{5};
+
 constexpr const char* const levelText[]{"TRC", "DBG", "INF", "WRN", "ERR", "FTL"};
 
+bool compressFile(const fs::path& source, const fs::path& target) {
+    boost::nowide::ifstream in(source.string(), std::ios::binary);
+    if (!in) return false;
+#ifdef WINDOWS
+    gzFile out{gzopen_w(target.wstring().c_str(), "wb9")};
+#else
+    gzFile out{gzopen(target.string().c_str(), "wb9")};
+#endif
+    if (!out) return false;
+    char buffer[64 * 1024];
+    bool ok{true};
+    while (ok) {
+        in.read(buffer, sizeof(buffer));
+        auto n{in.gcount()};
+        if (n == 0) break;
+        ok = gzwrite(out, buffer, static_cast<unsigned>(n)) == n;
+    }
+    ok = gzclose(out) == Z_OK && ok;
+    return ok;
+}
+
+struct FileInfo {
+    // Identifies the file, so that a rename by another process can be noticed
+    std::pair<std::uint64_t, std::uint64_t> Id;
+    std::uintmax_t Size;
+};
+
+std::optional<FileInfo> statFile(const fs::path& path) {
+#ifdef WINDOWS
+    HANDLE handle{CreateFileW(path.wstring().c_str(), 0,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (handle == INVALID_HANDLE_VALUE) return std::nullopt;
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok{GetFileInformationByHandle(handle, &info) != 0};
+    CloseHandle(handle);
+    if (!ok) return std::nullopt;
+    return FileInfo{{info.dwVolumeSerialNumber,
+                     std::uint64_t{info.nFileIndexHigh} << 32 | info.nFileIndexLow},
+                    std::uintmax_t{info.nFileSizeHigh} << 32 | info.nFileSizeLow};
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return std::nullopt;
+    return FileInfo{{static_cast<std::uint64_t>(st.st_dev), static_cast<std::uint64_t>(st.st_ino)},
+                    static_cast<std::uintmax_t>(st.st_size)};
+#endif
+}
+
+// The file (and its folder) is created only when the first record arrives, so that runs which log
+// nothing leave nothing behind. Old segments are compressed in the background.
+//
+// Several processes may share the log. Writers hold a shared lock on `vscch.log.lock` and reopen
+// the log if it was renamed, so nothing is appended to a rotated file. Rotating, and shifting
+// segments, takes the exclusive lock.
+class RotatingFile {
+    fs::path dir;
+    boost::nowide::ofstream file;
+    std::optional<std::pair<std::uint64_t, std::uint64_t>> openedId;
+    std::uintmax_t size{0};
+    bool failed{false};
+    std::optional<ip::file_lock> lock;
+    std::thread compressor;
+    // Renamed log, and its compressed copy once the compressor is done
+    std::optional<std::pair<fs::path, fs::path>> pending;
+
+    fs::path logPath() const {
+        return dir / "vscch.log";
+    }
+    fs::path segmentPath(int index) const {
+        return dir / ("vscch." + std::to_string(index) + ".log.gz");
+    }
+
+    bool open() {
+        boost::system::error_code ec;
+        fs::create_directories(dir, ec);
+        if (!lock) {
+            auto lockPath{dir / "vscch.log.lock"};
+            try {
+                boost::nowide::ofstream(lockPath.string(), std::ios::app);
+                lock.emplace(lockPath.string().c_str());
+            } catch (const ip::interprocess_exception&) {
+                // Without locking, rotations of concurrent processes may lose some records
+            }
+        }
+        file.close();
+        file.clear();
+        file.open(logPath().string(), std::ios::app);
+        if (!file) return false;
+        auto info{statFile(logPath())};
+        openedId = info ? std::optional{info->Id} : std::nullopt;
+        size = info ? info->Size : 0;
+        return true;
+    }
+
+    // Whether the opened file is no longer the log, e.g. rotated by another process. Otherwise
+    // `size` is updated, counting what other processes wrote.
+    bool moved() {
+        auto info{statFile(logPath())};
+        if (!openedId || !info || info->Id != *openedId) return true;
+        size = info->Size;
+        return false;
+    }
+
+    // Put the segment compressed last in place. Called with the exclusive lock held.
+    void publish() {
+        if (compressor.joinable()) compressor.join();
+        if (!pending) return;
+        auto [rotated, compressed]{*pending};
+        pending.reset();
+        boost::system::error_code ec;
+        // Try once more if the compressor failed (e.g. disk full)
+        if (fs::exists(compressed) || compressFile(rotated, compressed)) {
+            fs::remove(segmentPath(MAX_LOG_SEGMENTS), ec);
+            for (int i{MAX_LOG_SEGMENTS - 1}; i >= 1; i--) {
+                if (fs::exists(segmentPath(i))) fs::rename(segmentPath(i), segmentPath(i + 1), ec);
+            }
+            fs::rename(compressed, segmentPath(1), ec);
+        }
+        // Whatever happened, no uncompressed segment is kept, so that the size stays bounded
+        fs::remove(compressed, ec);
+        fs::remove(rotated, ec);
+    }
+
+    void rotate() {
+        std::optional<ip::scoped_lock<ip::file_lock>> guard;
+        if (lock) guard.emplace(*lock);
+        publish();
+        // Another process may have rotated it since the size was checked
+        if (moved() || size < MAX_LOG_SIZE) {
+            failed = !open();
+            return;
+        }
+        file.close();
+        auto rotated{fs::unique_path(logPath().string() + ".%%%%%%")};
+        boost::system::error_code ec;
+        fs::rename(logPath(), rotated, ec);
+        if (!ec) {
+            fs::path compressed{rotated.string() + ".gz"};
+            pending.emplace(rotated, compressed);
+            compressor = std::thread([rotated, compressed] {
+                if (!compressFile(rotated, compressed)) {
+                    boost::system::error_code ec;
+                    fs::remove(compressed, ec);
+                }
+            });
+        }
+        failed = !open();
+    }
+
+public:
+    explicit RotatingFile(const fs::path& dir) : dir(dir) {}
+
+    ~RotatingFile() {
+        if (!pending) return;
+        try {
+            std::optional<ip::scoped_lock<ip::file_lock>> guard;
+            if (lock) guard.emplace(*lock);
+            publish();
+        } catch (...) {
+            if (compressor.joinable()) compressor.join();
+        }
+    }
+
+    void write(const std::string& message) {
+        if (failed) return;
+        try {
+            {
+                std::optional<ip::sharable_lock<ip::file_lock>> guard;
+                if (lock) guard.emplace(*lock);
+                if ((!file.is_open() || moved()) && !open()) {
+                    // e.g. read-only home folder; logging to file is just skipped
+                    failed = true;
+                    return;
+                }
+                file << message << '\n';
+                file.flush();
+            }
+            size += message.size() + 1;
+            if (size >= MAX_LOG_SIZE) rotate();
+        } catch (const ip::interprocess_exception&) {
+            failed = true;
+        }
+    }
+};
+
+#ifdef VSCCH_LEAN
+
+std::mutex mutex;
+bool initialized{false};
+Severity consoleLevel{Severity::warning};
+std::optional<RotatingFile> logFile;
+
+// Local time formatted by `format`, followed by microseconds if `micro`
+std::string timestamp(const char* format, bool micro) {
+    auto now{std::chrono::system_clock::now()};
+    auto time{std::chrono::system_clock::to_time_t(now)};
+    char buffer[64];
+    auto length{std::strftime(buffer, sizeof(buffer), format, std::localtime(&time))};
+    std::string result(buffer, length);
+    if (micro) {
+        auto us{std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) %
+                std::chrono::seconds(1)};
+        std::snprintf(buffer, sizeof(buffer), ".%06lld", static_cast<long long>(us.count()));
+        result += buffer;
+    }
+    return result;
+}
+
+#else
+
 void consoleFormatter(const logging::record_view& rec, logging::formatting_ostream& strm) {
     auto level{rec[trivial::severity]};
     auto date_time_formatter{
@@ -60,17 +304,76 @@ void fileFormatter(const logging::record_view& rec, logging::formatting_ostream&
     strm << " [" << levelText[level.get()] << "] " << rec[expr::smessage];
 }
 
+// Sink backend writing formatted records to a RotatingFile
+class RotatingFileBackend
+    : public sinks::basic_formatted_sink_backend<char, sinks::synchronized_feeding> {
+    RotatingFile file;
+
+public:
+    explicit RotatingFileBackend(const fs::path& dir) : file(dir) {}
+
+    void consume(const logging::record_view&, const string_type& message) {
+        file.write(message);
+    }
+};
+
+#endif
+
 }  // namespace
 
-src::severity_logger<trivial::severity_level> logger{};
+#ifdef VSCCH_LEAN
+
+void init(bool verbose) {
+    std::lock_guard lock(mutex);
+    logFile.emplace(Native::getStateDir() / "vscch");
+    consoleLevel = verbose ? Severity::info : Severity::warning;
+    initialized = true;
+#if WINDOWS
+    SetConsoleCP(CP_UTF8);
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+}
+
+bool enabled(Severity level) {
+    return initialized && level >= Severity::debug;
+}
+
+void write(Severity level, const std::string& message) {
+    auto index{static_cast<int>(level)};
+    std::lock_guard lock(mutex);
+    logFile->write(timestamp("%Y-%m-%d %H:%M:%S", true) + " [" + levelText[index] + "] " + message);
+    if (level < consoleLevel) return;
+#ifdef WINDOWS
+    constexpr WORD colors[]{0x08, 0x07, 0x0F, 0x0E, 0x0C, 0x04};
+    auto hstdout{GetStdHandle(STD_OUTPUT_HANDLE)};
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(hstdout, &csbi);
+    SetConsoleTextAttribute(hstdout, colors[index]);
+    std::cout << "[" << timestamp("%H:%M:%S", false) << " " << levelText[index] << "] " << message
+              << std::endl;
+    SetConsoleTextAttribute(hstdout, csbi.wAttributes);
+#else
+    constexpr const char* colors[]{"\033[01;30m", "\033[37m",    "\033[01;37m",
+                                   "\033[01;33m", "\033[01;31m", "\033[31m"};
+    std::cout << colors[index] << "[" << timestamp("%H:%M:%S", false) << " " << levelText[index]
+              << "] " << message << "\033[m" << std::endl;
+#endif
+}
+
+#else
+
+src::severity_logger_mt<trivial::severity_level> logger{};
 
 void init(bool verbose) {
     logging::add_common_attributes();
 
-    auto fileSink{boost::log::add_file_log("vscch.log")};
+    auto fileBackend{boost::make_shared<RotatingFileBackend>(Native::getStateDir() / "vscch")};
+    auto fileSink{boost::make_shared<sinks::synchronous_sink<RotatingFileBackend>>(fileBackend)};
     // std::locale loc = boost::locale::generator()("en_US.UTF-8");
     // fileSink->imbue(loc);
     fileSink->set_formatter(&fileFormatter);
+    fileSink->set_filter(trivial::severity >= trivial::debug);
+    logging::core::get()->add_sink(fileSink);
 
     boost::shared_ptr<sinks::synchronous_sink<sinks::text_ostream_backend>> consoleSink{
         logging::add_console_log(std::cout)};
@@ -88,4 +391,6 @@ void init(bool verbose) {
     }
 }
 
-}  // namespace Log
\ No newline at end of file
+#endif  // VSCCH_LEAN
+
+}  // namespace Log
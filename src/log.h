@@ -21,15 +21,46 @@
 #include <windows.h>
 #endif
 
+#ifdef VSCCH_LEAN
+#include <sstream>
+#include <string>
+#else
 #include <boost/log/sources/logger.hpp>
 #include <boost/log/trivial.hpp>
+#endif
 #include <iostream>
 
 #include "native.h"
 
 namespace Log {
 
-extern boost::log::sources::severity_logger<boost::log::trivial::severity_level> logger;
+#ifdef VSCCH_LEAN
+
+// Lean builds write records directly, without Boost.Log
+enum class Severity { trace, debug, info, warning, error, fatal };
+
+void init(bool verbose);
+bool enabled(Severity level);
+void write(Severity level, const std::string& message);
+
+template <typename... Ts>
+void log(Severity level, const Ts&... content) {
+    if (!enabled(level)) return;
+    std::ostringstream oss;
+    (oss << ... << content);
+    write(level, oss.str());
+}
+
+}  // namespace Log
+
+#define LOG_DBG(...) Log::log(Log::Severity::debug, ##__VA_ARGS__)
+#define LOG_INF(...) Log::log(Log::Severity::info, ##__VA_ARGS__)
+#define LOG_WRN(...) Log::log(Log::Severity::warning, ##__VA_ARGS__)
+#define LOG_ERR(...) Log::log(Log::Severity::error, ##__VA_ARGS__)
+
+#else
+
+extern boost::log::sources::severity_logger_mt<boost::log::trivial::severity_level> logger;
 void init(bool verbose);
 
 template <typename... Ts>
@@ -81,3 +112,5 @@ void log(boost::log::trivial::severity_level level, const Ts&... content) {
 #define LOG_INF(...) Log::log(boost::log::trivial::info, ##__VA_ARGS__)
 #define LOG_WRN(...) Log::log(boost::log::trivial::warning, ##__VA_ARGS__)
 #define LOG_ERR(...) Log::log(boost::log::trivial::error, ##__VA_ARGS__)
+
+#endif  // VSCCH_LEAN
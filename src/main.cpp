@@ -24,6 +24,7 @@
 
 #include "cli.h"
 #include "environment.h"
+#include "http_client.h"
 #include "log.h"
 #include "native.h"
 #include "server.h"
@@ -31,6 +32,9 @@
 int main(int argc, char** argv) {
     boost::nowide::nowide_filesystem();
     boost::nowide::args _(argc, argv);
+    if (auto exitCode{Cli::runSubcommand(argc, argv)}) {
+        return *exitCode;
+    }
     Cli::init(argc, argv);
     // LOG_WRN("你好");
     Environment env;
@@ -40,4 +44,6 @@ int main(int argc, char** argv) {
     else
 #endif
         Cli::runCli(env);
+    // Analytics may still be in flight
+    HttpClient::exit(0);
 }
\ No newline at end of file
@@ -23,22 +23,36 @@
 #include <shlobj.h>
 #include <versionhelpers.h>
 
+#include <boost/process.hpp>
+
 #else
 
+#include <fcntl.h>
 #include <pwd.h>
+#include <spawn.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+extern char** environ;
+
 #ifdef LINUX
 #include <boost/filesystem.hpp>
 #else
+#include <mach-o/dyld.h>
 #include <sys/sysctl.h>
 #endif
 
 #endif
 
 #include <boost/nowide/convert.hpp>
+#include <map>
 #include <stdexcept>
+#include <string_view>
 
 #include "log.h"
 
@@ -212,11 +226,83 @@ boost::filesystem::path getAppdata() {
 #endif
 }
 
+boost::filesystem::path getCacheDir() {
+#ifdef WINDOWS
+    return boost::filesystem::path(getSpecialFolder(FOLDERID_LocalAppData));
+#else
+# ifdef LINUX
+    const char* xdgCache{getenv("XDG_CACHE_HOME")};
+    if (xdgCache != nullptr && *xdgCache != '\0') {
+        return boost::filesystem::path(xdgCache);
+    }
+    // ~/.config -> ~/.cache
+    return getAppdata().parent_path() / ".cache";
+# else
+    // ~/Library/Application Support -> ~/Library/Caches
+    return getAppdata().parent_path() / "Caches";
+# endif
+#endif
+}
+
+// Logs and other data which should persist but are not worth backing up
+boost::filesystem::path getStateDir() {
+#ifdef WINDOWS
+    return getCacheDir();
+#else
+# ifdef LINUX
+    const char* xdgState{getenv("XDG_STATE_HOME")};
+    if (xdgState != nullptr && *xdgState != '\0') {
+        return boost::filesystem::path(xdgState);
+    }
+    // ~/.config -> ~/.local/state
+    return getAppdata().parent_path() / ".local/state";
+# else
+    // ~/Library/Application Support -> ~/Library/Logs
+    return getAppdata().parent_path() / "Logs";
+# endif
+#endif
+}
+
 boost::filesystem::path getTempFilePath(const std::string& filename) {
     boost::filesystem::path tempDir{boost::filesystem::temp_directory_path()};
     return tempDir / filename;
 }
 
+boost::filesystem::path getExecutablePath() {
+#ifdef WINDOWS
+    wchar_t path[MAX_PATH];
+    GetModuleFileName(nullptr, path, MAX_PATH);
+    return boost::filesystem::path(narrow(path));
+#elif defined(LINUX)
+    return boost::filesystem::read_symlink("/proc/self/exe");
+#else
+    char path[1024];
+    std::uint32_t size{sizeof(path)};
+    if (_NSGetExecutablePath(path, &size) != 0) {
+        throw std::runtime_error("Failed to get executable path.");
+    }
+    return boost::filesystem::canonical(path);
+#endif
+}
+
+std::uint64_t getPhysicalMemory() {
+#ifdef WINDOWS
+    MEMORYSTATUSEX status{.dwLength = sizeof(MEMORYSTATUSEX)};
+    if (!GlobalMemoryStatusEx(&status)) return 0;
+    return status.ullTotalPhys;
+#elif defined(LINUX)
+    auto pages{sysconf(_SC_PHYS_PAGES)};
+    auto pageSize{sysconf(_SC_PAGE_SIZE)};
+    if (pages < 0 || pageSize < 0) return 0;
+    return static_cast<std::uint64_t>(pages) * pageSize;
+#else
+    std::uint64_t memSize{0};
+    std::size_t size{sizeof(memSize)};
+    if (sysctlbyname("hw.memsize", &memSize, &size, nullptr, 0) != 0) return 0;
+    return memSize;
+#endif
+}
+
 char getch() {
 #if WINDOWS
     int ch{_getch()};
@@ -264,4 +350,250 @@ void checkSystemVersion() {
 #endif
 }
 
+#ifdef WINDOWS
+
+std::optional<SpawnResult> spawn(const SpawnOptions& options) {
+    // There is no fork on Windows, so CreateProcess (what Boost.Process uses) is already cheap
+    namespace bp = boost::process;
+    using Stream = SpawnOptions::Stream;
+    if (options.Args.empty()) return std::nullopt;
+    auto exe{bp::search_path(options.Args[0])};
+    if (exe.empty()) exe = options.Args[0];
+    std::vector<std::string> args(options.Args.begin() + 1, options.Args.end());
+    auto env{boost::this_process::environment()};
+    for (const auto& [key, value] : options.Env) {
+        env[key] = value;
+    }
+    auto cwd{options.Cwd.empty() ? boost::filesystem::current_path() : options.Cwd};
+    try {
+        if (options.Detach) {
+            bp::spawn(exe, args, env, bp::start_dir(cwd), bp::std_out > bp::null,
+                      bp::std_err > bp::null);
+            return SpawnResult{0, {}};
+        }
+        bp::ipstream out;
+        bp::child proc;
+        auto launch{[&](auto&&... redirections) {
+            if (options.Stdin == Stream::Null) {
+                proc = bp::child(exe, args, env, bp::start_dir(cwd), bp::std_in < bp::null,
+                                 redirections...);
+            } else {
+                proc = bp::child(exe, args, env, bp::start_dir(cwd), redirections...);
+            }
+        }};
+        auto withStderr{[&](auto&& stdoutRedirection) {
+            switch (options.Stderr) {
+                case Stream::Null: launch(stdoutRedirection, bp::std_err > bp::null); break;
+                case Stream::Capture: launch(stdoutRedirection, bp::std_err > out); break;
+                default: launch(stdoutRedirection);
+            }
+        }};
+        if (options.Stdout == Stream::Capture && options.Stderr == Stream::Capture) {
+            launch((bp::std_out & bp::std_err) > out);
+        } else if (options.Stdout == Stream::Capture) {
+            withStderr(bp::std_out > out);
+        } else if (options.Stdout == Stream::Null) {
+            withStderr(bp::std_out > bp::null);
+        } else {
+            withStderr(bp::std_out > stdout);
+        }
+        SpawnResult result{};
+        if (options.Stdout == Stream::Capture || options.Stderr == Stream::Capture) {
+            result.Output.assign(std::istreambuf_iterator<char>(out), {});
+        }
+        proc.wait();
+        result.ExitCode = proc.exit_code();
+        return result;
+    } catch (const std::exception& e) {
+        LOG_DBG("Spawn ", options.Args[0], " failed: ", e.what());
+        return std::nullopt;
+    }
+}
+
+#else
+
+namespace {
+
+// Owns a posix_spawn_file_actions_t / posix_spawnattr_t for the duration of one spawn
+struct SpawnActions {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    SpawnActions() {
+        posix_spawn_file_actions_init(&actions);
+        posix_spawnattr_init(&attr);
+    }
+    ~SpawnActions() {
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+    }
+};
+
+bool makePipe(int (&fds)[2]) {
+#ifdef LINUX
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+#ifdef MACOS
+#define HAS_SPAWN_CHDIR 1
+#elif defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 29)
+#define HAS_SPAWN_CHDIR 1
+#endif
+#endif
+
+#ifndef HAS_SPAWN_CHDIR
+// Where posix_spawnp would find `file` once in `cwd`. The shell which changes directory for us
+// would report a missing program only by exit code 127, like a program may do by itself, so look
+// it up first.
+std::optional<std::string> findExecutable(const std::string& file,
+                                          const boost::filesystem::path& cwd) {
+    auto usable{[&](const boost::filesystem::path& path) {
+        auto full{path.is_absolute() ? path : cwd / path};
+        return access(full.c_str(), X_OK) == 0 && !boost::filesystem::is_directory(full);
+    }};
+    if (file.find('/') != std::string::npos) {
+        if (usable(file)) return file;
+        return std::nullopt;
+    }
+    const char* pathEnv{getenv("PATH")};
+    std::string_view dirs{pathEnv ? pathEnv : "/bin:/usr/bin"};
+    while (true) {
+        auto end{dirs.find(':')};
+        std::string dir(dirs.substr(0, end));
+        // An empty entry means the current directory; keep a slash so that no search is done again
+        auto candidate{boost::filesystem::path(dir.empty() ? "." : dir) / file};
+        if (usable(candidate)) return candidate.string();
+        if (end == std::string_view::npos) return std::nullopt;
+        dirs.remove_prefix(end + 1);
+    }
+}
+#endif
+
+}  // namespace
+
+std::optional<SpawnResult> spawn(const SpawnOptions& options) {
+    using Stream = SpawnOptions::Stream;
+    if (options.Args.empty()) return std::nullopt;
+    std::vector<std::string> args;
+    args.insert(args.end(), options.Args.begin(), options.Args.end());
+#ifndef HAS_SPAWN_CHDIR
+    if (!options.Cwd.empty()) {
+        // No file action for chdir in this libc, let a shell change directory before exec
+        auto exe{findExecutable(args[0], options.Cwd)};
+        if (!exe || !boost::filesystem::is_directory(options.Cwd)) {
+            LOG_DBG("Cannot run ", args[0], " in ", options.Cwd);
+            return std::nullopt;
+        }
+        args[0] = *exe;
+        args.insert(args.begin(), {"/bin/sh", "-c", "cd -- \"$0\" && exec \"$@\"",
+                                   options.Cwd.string()});
+    }
+#endif
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    std::map<std::string, std::string> overrides(options.Env.begin(), options.Env.end());
+    std::vector<std::string> envStrings;
+    for (char** e{environ}; *e; e++) {
+        std::string_view entry{*e};
+        if (!overrides.count(std::string(entry.substr(0, entry.find('='))))) {
+            envStrings.emplace_back(entry);
+        }
+    }
+    for (const auto& [key, value] : overrides) {
+        envStrings.push_back(key + "=" + value);
+    }
+    std::vector<char*> envp;
+    for (auto& entry : envStrings) {
+        envp.push_back(entry.data());
+    }
+    envp.push_back(nullptr);
+
+    bool capture{!options.Detach &&
+                 (options.Stdout == Stream::Capture || options.Stderr == Stream::Capture)};
+    int fds[2]{-1, -1};
+    if (capture && !makePipe(fds)) {
+        LOG_DBG("pipe failed: ", std::strerror(errno));
+        return std::nullopt;
+    }
+    SpawnActions sa;
+    auto redirect{[&](int target, Stream stream) {
+        if (stream == Stream::Null || (options.Detach && stream == Stream::Capture)) {
+            posix_spawn_file_actions_addopen(&sa.actions, target, "/dev/null",
+                                             target ? O_WRONLY : O_RDONLY, 0);
+        } else if (stream == Stream::Capture) {
+            // dup2 clears close-on-exec on the target; the pipe itself is closed by exec
+            posix_spawn_file_actions_adddup2(&sa.actions, fds[1], target);
+        }
+    }};
+    redirect(STDIN_FILENO, options.Stdin == Stream::Capture ? Stream::Inherit : options.Stdin);
+    redirect(STDOUT_FILENO, options.Stdout);
+    redirect(STDERR_FILENO, options.Stderr);
+#ifdef HAS_SPAWN_CHDIR
+    if (!options.Cwd.empty()) {
+        posix_spawn_file_actions_addchdir_np(&sa.actions, options.Cwd.c_str());
+    }
+#endif
+    short flags{POSIX_SPAWN_SETSIGDEF};
+#ifdef POSIX_SPAWN_USEVFORK
+    // Already the default since glibc 2.24 (clone with CLONE_VM | CLONE_VFORK); older glibc
+    // needs it to avoid fork
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&sa.attr, &defaults);
+    posix_spawnattr_setflags(&sa.attr, flags);
+
+    pid_t pid;
+    int error{posix_spawnp(&pid, argv[0], &sa.actions, &sa.attr, argv.data(), envp.data())};
+    if (capture) close(fds[1]);
+    if (error != 0) {
+        LOG_DBG("posix_spawnp ", argv[0], " failed: ", std::strerror(error));
+        if (capture) close(fds[0]);
+        return std::nullopt;
+    }
+    if (options.Detach) {
+        // Reap it whenever it exits so that no zombie is left behind
+        std::thread([pid] { waitpid(pid, nullptr, 0); }).detach();
+        return SpawnResult{0, {}};
+    }
+
+    SpawnResult result{};
+    if (capture) {
+        char buffer[4096];
+        while (true) {
+            auto n{read(fds[0], buffer, sizeof(buffer))};
+            if (n > 0) {
+                result.Output.append(buffer, n);
+            } else if (n == 0 || errno != EINTR) {
+                break;
+            }
+        }
+        close(fds[0]);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return std::nullopt;
+    }
+    if (WIFEXITED(status)) {
+        result.ExitCode = WEXITSTATUS(status);
+    } else {
+        result.ExitCode = 128 + WTERMSIG(status);
+    }
+    return result;
+}
+
+#endif
+
 }  // namespace Native
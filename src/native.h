@@ -22,8 +22,11 @@
 #endif
 
 #include <boost/filesystem.hpp>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Native {
 
@@ -53,21 +56,54 @@ bool is64BitExecutable(const std::string& path);
 bool isGbkCp();
 
 boost::filesystem::path getAppdata();
+boost::filesystem::path getCacheDir();
+boost::filesystem::path getStateDir();
 boost::filesystem::path getTempFilePath(const std::string& filename);
+boost::filesystem::path getExecutablePath();
+std::uint64_t getPhysicalMemory();
 char getch();
 void checkSystemVersion();
 
+struct SpawnOptions {
+    enum class Stream { Inherit, Null, Capture };
+
+    // Args[0] is the program, searched in PATH if it has no slash
+    std::vector<std::string> Args;
+    // Current directory of the child, or the current one if empty
+    boost::filesystem::path Cwd;
+    // Added to (or replacing in) the inherited environment
+    std::vector<std::pair<std::string, std::string>> Env;
+    Stream Stdin{Stream::Inherit};
+    Stream Stdout{Stream::Capture};
+    // Capture means merging into the captured stdout
+    Stream Stderr{Stream::Inherit};
+    // Return right after starting, without waiting or capturing
+    bool Detach{false};
+};
+
+struct SpawnResult {
+    // 128 + signal number if killed by a signal
+    int ExitCode;
+    std::string Output;
+};
+
+// Run a program. On POSIX it uses posix_spawn (vfork semantics, no copy of the page tables), which
+// stays cheap however large this process is. Returns nullopt if the program cannot be started.
+std::optional<SpawnResult> spawn(const SpawnOptions& options);
+
 #if _WIN32
 # define WINDOWS 1
 
 # define SCRIPT_EXT "ps1"
 # define PATH_SLASH "\\"
 # define EXE_EXT "exe"
+# define SELF_FILENAME "vscch.exe"
 constexpr const char newLine{'\r'};
 #else
 
 # define PATH_SLASH "/"
 # define EXE_EXT "out"
+# define SELF_FILENAME "vscch"
 constexpr const char newLine{'\n'};
 
 # ifdef __APPLE__
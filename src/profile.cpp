@@ -0,0 +1,222 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "profile.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/process.hpp>
+#include <boost/program_options.hpp>
+#include <iostream>
+#include <optional>
+#include <sstream>
+
+#include "log.h"
+#include "native.h"
+
+namespace Profile {
+
+namespace bp = boost::process;
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+using namespace std::literals;
+
+namespace {
+
+// Profiler executable, and the tool which turns its raw output into a summary
+struct Tool {
+    const char* name;
+    const char* recorder;
+    const char* reporter;
+};
+
+const Tool TOOLS[]{
+    {"perf", "perf", "perf"},
+    {"callgrind", "valgrind", "callgrind_annotate"},
+    {"heaptrack", "heaptrack", "heaptrack_print"},
+};
+
+const Tool* findTool(const std::string& name) {
+    for (const auto& tool : TOOLS) {
+        if (name == tool.name) return &tool;
+    }
+    return nullptr;
+}
+
+bool installed(const Tool& tool) {
+    return !bp::search_path(tool.recorder).empty() && !bp::search_path(tool.reporter).empty();
+}
+
+// Run with inherited stdin/stdout, so that the program can still be used interactively. Returns
+// the exit code, which perf and valgrind pass through from the profiled program.
+std::optional<int> run(const std::string& exe, const std::vector<std::string>& args) {
+    std::vector<std::string> argv{exe};
+    argv.insert(argv.end(), args.begin(), args.end());
+    using Stream = Native::SpawnOptions::Stream;
+    auto result{Native::spawn({.Args = std::move(argv), .Stdout = Stream::Inherit})};
+    if (!result) {
+        LOG_ERR("运行 ", exe, " 时失败。");
+        return std::nullopt;
+    }
+    return result->ExitCode;
+}
+
+std::optional<std::string> capture(const std::string& exe, const std::vector<std::string>& args) {
+    std::vector<std::string> argv{exe};
+    argv.insert(argv.end(), args.begin(), args.end());
+    auto result{Native::spawn({.Args = std::move(argv),
+                               .Stderr = Native::SpawnOptions::Stream::Null})};
+    if (!result) {
+        LOG_ERR("运行 ", exe, " 时失败。");
+        return std::nullopt;
+    }
+    if (result->ExitCode != 0) return std::nullopt;
+    return std::move(result->Output);
+}
+
+// The output file, possibly with a compression suffix (heaptrack appends one)
+std::optional<fs::path> findData(const fs::path& base) {
+    for (auto ext : {".zst", ".gz", ""}) {
+        fs::path p{base.string() + ext};
+        if (fs::exists(p)) return p;
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+std::vector<std::string> availableTools() {
+    std::vector<std::string> result;
+    for (const auto& tool : TOOLS) {
+        if (installed(tool)) {
+            result.push_back(tool.name);
+        }
+    }
+    return result;
+}
+
+int profileCommand(int argc, char** argv) {
+    std::string toolName, program, outDir;
+    std::vector<std::string> programArgs;
+    int top;
+    // clang-format off
+    po::options_description desc("profile Options", 79);
+    desc.add_options()
+        ("tool", po::value(&toolName), "性能分析工具，可为  perf、callgrind  或 heaptrack")
+        ("program", po::value(&program), "要分析的程序")
+        ("args", po::value(&programArgs), "传给程序的参数（写在  --  之后）")
+        ("output,o", po::value(&outDir)->default_value("profiles"), "保存分析结果的文件夹")
+        ("top,n", po::value(&top)->default_value(20), "摘要中显示的条目数")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("tool", 1).add("program", 1).add("args", -1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help") || program.empty()) {
+        std::cout << "用法：vscch3 profile <perf|callgrind|heaptrack> <program> [options] [-- <args...>]"
+                  << std::endl;
+        desc.print(std::cout, 30);
+        return vm.count("help") ? 0 : 1;
+    }
+    auto tool{findTool(toolName)};
+    if (!tool) {
+        LOG_ERR(toolName, " 不是支持的性能分析工具。可选值为 perf、callgrind 或 heaptrack。");
+        return 1;
+    }
+    if (!installed(*tool)) {
+        LOG_ERR("未找到 ", tool->recorder, " 或 ", tool->reporter, "。");
+        return 1;
+    }
+    fs::create_directories(outDir);
+    auto base{fs::absolute(outDir) / (fs::path(program).stem().string() + "." + tool->name)};
+    auto summaryPath{base.string() + ".txt"};
+
+    std::vector<std::string> recordArgs, reportArgs;
+    auto topStr{std::to_string(top)};
+    fs::path data;
+    if (toolName == "perf") {
+        data = base.string() + ".data";
+        recordArgs = {"record", "-g", "-o", data.string(), "--", program};
+        // Flat profile: self time per symbol
+        reportArgs = {"report", "-i", data.string(), "--stdio", "--no-children", "--sort",
+                      "symbol", "-g", "none", "--percent-limit", "0.5"};
+    } else if (toolName == "callgrind") {
+        data = base.string() + ".out";
+        recordArgs = {"--tool=callgrind", "--callgrind-out-file=" + data.string(), program};
+        reportArgs = {"--inclusive=no", "--threshold=99", data.string()};
+    } else {
+        recordArgs = {"-o", base.string(), program};
+    }
+    recordArgs.insert(recordArgs.end(), programArgs.begin(), programArgs.end());
+
+    // Whether profiling succeeded is told by the data file, so remove the one of a previous run
+    while (auto stale{findData(data.empty() ? base : data)}) {
+        fs::remove(*stale);
+    }
+
+    LOG_INF("使用 ", toolName, " 运行 ", program, " ...");
+    auto exitCode{run(tool->recorder, recordArgs)};
+    if (!exitCode) {
+        LOG_ERR("性能分析失败。");
+        return 1;
+    }
+    if (toolName == "heaptrack") {
+        if (auto found{findData(base)}) {
+            data = *found;
+        }
+        // Top-N allocation report
+        reportArgs = {"-f", data.string(), "--print-allocators", "1", "--print-peaks", "1",
+                      "--print-temporary", "0", "--print-leaks", "0", "-n", topStr};
+    }
+    if (data.empty() || !fs::exists(data)) {
+        LOG_ERR("性能分析失败：未找到 ", tool->recorder, " 的输出文件。");
+        return 1;
+    }
+    if (*exitCode != 0) {
+        LOG_WRN("程序返回 ", *exitCode, "，分析数据仍已保存。");
+    }
+    auto summary{capture(tool->reporter, reportArgs)};
+    if (!summary) {
+        LOG_ERR("无法生成分析摘要。");
+        return 1;
+    }
+    fs::save_string_file(summaryPath, *summary);
+
+    // Print the beginning of the report (with some room for headers), skipping perf comments
+    std::istringstream iss(*summary);
+    std::string line;
+    int lines{0};
+    std::cout << std::endl;
+    while (std::getline(iss, line) && lines < top + 10) {
+        if (toolName == "perf" && (line.starts_with("#") || line.empty())) continue;
+        std::cout << line << std::endl;
+        lines++;
+    }
+    std::cout << std::endl;
+    LOG_INF("完整摘要已保存到 ", summaryPath, "。");
+    return 0;
+}
+
+}  // namespace Profile
@@ -0,0 +1,157 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "runner.h"
+
+#include "native.h"
+
+#ifndef WINDOWS
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#endif
+
+#include <iostream>
+
+#include "log.h"
+
+namespace Runner {
+
+#ifdef WINDOWS
+
+int runCommand(int, char**) {
+    LOG_ERR("Windows 下请使用 pause-console.ps1。");
+    return 1;
+}
+
+#else
+
+using namespace std::literals;
+
+namespace {
+
+const char RESET[]{"\033[0m"};
+const char BG_RED[]{"\033[41m"};
+const char BG_GREEN[]{"\033[42m"};
+const char BG_YELLOW_FG_BLACK[]{"\033[43;30m"};
+const char BG_CYAN_FG_BLACK[]{"\033[46;30m"};
+const char FG_RED[]{"\033[0;31m"};
+const char FG_GREEN[]{"\033[0;32m"};
+const char FG_CYAN[]{"\033[0;36m"};
+// PowerLine Glyphs < and >
+const char GT[]{"\ue0b0"};
+const char LT[]{"\ue0b2"};
+
+double toSeconds(const timeval& tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void waitKey() {
+    if (!isatty(STDIN_FILENO)) return;
+    termios orig;
+    tcgetattr(STDIN_FILENO, &orig);
+    auto raw{orig};
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    char c;
+    [[maybe_unused]] auto _{read(STDIN_FILENO, &c, 1)};
+    tcsetattr(STDIN_FILENO, TCSANOW, &orig);
+}
+
+}  // namespace
+
+int runCommand(int argc, char** argv) {
+    if (argc < 2 || argv[1] == "-h"sv || argv[1] == "--help"sv) {
+        std::cout << "用法：vscch3 run <Executable> [<Arguments...>]" << std::endl;
+        return argc < 2;
+    }
+    // Set the window title
+    std::cout << "\033]2;" << argv[1] << "\a" << std::flush;
+
+    // Let Ctrl-C stop the program only, so that the result is still shown
+    struct sigaction ignore {}, origInt{}, origQuit{};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGINT, &ignore, &origInt);
+    sigaction(SIGQUIT, &ignore, &origQuit);
+
+    auto start{std::chrono::steady_clock::now()};
+    auto pid{fork()};
+    if (pid < 0) {
+        LOG_ERR("无法创建进程：", std::strerror(errno));
+        return 1;
+    }
+    if (pid == 0) {
+        sigaction(SIGINT, &origInt, nullptr);
+        sigaction(SIGQUIT, &origQuit, nullptr);
+        execvp(argv[1], argv + 1);
+        std::fprintf(stderr, "无法运行 %s：%s\n", argv[1], std::strerror(errno));
+        _exit(127);
+    }
+    int status{0};
+    rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    auto elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    sigaction(SIGINT, &origInt, nullptr);
+    sigaction(SIGQUIT, &origQuit, nullptr);
+
+    // Same as the exit status reported by shells
+    int exitCode{WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status)};
+#ifdef MACOS
+    double peakMemory{usage.ru_maxrss / 1048576.0};
+#else
+    double peakMemory{usage.ru_maxrss / 1024.0};
+#endif
+    auto exitFgColor{exitCode == 0 ? FG_GREEN : FG_RED};
+    auto exitBgColor{exitCode == 0 ? BG_GREEN : BG_RED};
+
+    std::printf("\n----------------");
+    std::printf("%s%s%s", exitFgColor, LT, RESET);
+    std::printf("%s 返回值 %d ", exitBgColor, exitCode);
+    if (WIFSIGNALED(status)) {
+        std::printf("(%s) ", strsignal(WTERMSIG(status)));
+    }
+    std::printf("%s", RESET);
+    std::printf("%s 用时 %.6fs %s", BG_YELLOW_FG_BLACK, elapsed, RESET);
+    std::printf("%s 用户 %.6fs 系统 %.6fs 内存 %.1f MiB %s", BG_CYAN_FG_BLACK,
+                toSeconds(usage.ru_utime), toSeconds(usage.ru_stime), peakMemory, RESET);
+    std::printf("%s%s%s", FG_CYAN, GT, RESET);
+    std::printf("----------------\n");
+#ifdef MACOS
+    // "close window" is controlled by Terminal.app preference
+    std::printf("进程已退出。按任意键退出...");
+#else
+    std::printf("进程已退出。按任意键关闭窗口...");
+#endif
+    std::fflush(stdout);
+    waitKey();
+    return exitCode;
+}
+
+#endif
+
+}  // namespace Runner
@@ -0,0 +1,263 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "generator.h"
+#include "log.h"
+
+namespace Scan {
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+using json = nlohmann::json;
+
+namespace {
+
+enum class State { Current, Outdated, Modified, Legacy, Broken, Count };
+constexpr const char* stateText[]{"最新", "过时", "已修改", "旧版", "损坏"};
+
+// Parallel depth-first walk. Only folders not yet listed are kept, so memory grows with the depth
+// and width of the tree rather than its size.
+class Walker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<fs::path> pending;
+    unsigned active{0};
+
+    static bool skip(const fs::path& name) {
+        auto text{name.string()};
+        // Hidden folders (.git etc.) and dependency folders never contain workspaces
+        return (text.size() > 1 && text[0] == '.') || text == "node_modules";
+    }
+
+    template <typename F>
+    void work(const F& visit) {
+        std::vector<fs::path> found;
+        while (true) {
+            fs::path dir;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&] { return !pending.empty() || active == 0; });
+                if (pending.empty()) return;
+                dir = std::move(pending.back());
+                pending.pop_back();
+                active++;
+            }
+            boost::system::error_code ec;
+            for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+                auto status{it->symlink_status(ec)};
+                if (ec || !fs::is_directory(status)) continue;
+                auto name{it->path().filename()};
+                if (name == ".vscode") {
+                    visit(dir);
+                } else if (!skip(name)) {
+                    found.push_back(it->path());
+                }
+            }
+            std::lock_guard lock(mutex);
+            std::move(found.begin(), found.end(), std::back_inserter(pending));
+            found.clear();
+            active--;
+            cv.notify_all();
+        }
+    }
+
+public:
+    template <typename F>
+    void run(const fs::path& root, unsigned jobs, const F& visit) {
+        pending.push_back(root);
+        std::vector<std::thread> threads;
+        for (unsigned i{0}; i < jobs; i++) {
+            threads.emplace_back([&] { work(visit); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+};
+
+// Fingerprints of files the current version generates, computed once for each set of options and
+// host inputs. Fingerprinted files do not depend on the workspace path. Host inputs recorded in
+// the manifest are replayed, so that nothing is probed or built, and a workspace configured on
+// another machine is compared with what that machine would get.
+class Renderer {
+    std::mutex mutex;
+    std::map<std::string, std::shared_future<json>> results;
+
+    static json render(CurrentOptions options, const json& hostInputs) {
+        auto dir{fs::temp_directory_path() / fs::unique_path("vscch-scan-%%%%%%")};
+        options.WorkspacePath = dir.string();
+        json fingerprints;
+        try {
+            fingerprints = Generator(options, hostInputs).generateConfigs(dir / ".vscode");
+        } catch (const std::exception& e) {
+            LOG_WRN("生成配置失败：", e.what());
+        }
+        boost::system::error_code ec;
+        fs::remove_all(dir, ec);
+        return fingerprints;
+    }
+
+public:
+    json get(const json& options, const json& hostInputs) {
+        auto key(json::array({options, hostInputs}));
+        key[0].erase("WorkspacePath");
+        std::promise<json> promise;
+        std::shared_future<json> future;
+        {
+            std::lock_guard lock(mutex);
+            auto [it, inserted]{results.try_emplace(key.dump())};
+            if (inserted) {
+                it->second = promise.get_future().share();
+            } else {
+                future = it->second;
+            }
+        }
+        if (future.valid()) return future.get();
+        auto result{render(Generator::optionsFromJson(options), hostInputs)};
+        promise.set_value(result);
+        return result;
+    }
+};
+
+struct ScanOptions {
+    bool Upgrade;
+    bool Force;
+    bool All;
+};
+
+State check(const fs::path& workspace, const ScanOptions& scanOptions, Renderer& renderer) {
+    auto dotVscode{workspace / ".vscode"};
+    auto manifestPath{dotVscode / Generator::MANIFEST};
+    if (!fs::exists(manifestPath)) {
+        // Configured by versions before the manifest (or by hand)
+        return fs::exists(dotVscode / "c_cpp_properties.json") ? State::Legacy : State::Count;
+    }
+    json manifest;
+    try {
+        std::string content;
+        fs::load_string_file(manifestPath, content);
+        manifest = json::parse(content);
+    } catch (...) {
+        return State::Broken;
+    }
+    if (!manifest.contains("Options") || !manifest.contains("Fingerprints")) {
+        return State::Broken;
+    }
+    const auto& recorded{manifest["Fingerprints"]};
+    bool modified{false};
+    for (const char* filename : Generator::FINGERPRINTED_FILES) {
+        auto actual{Generator::fingerprint(dotVscode / filename)};
+        if (actual.value_or("") != recorded.value(filename, "")) {
+            modified = true;
+        }
+    }
+    auto expected{renderer.get(manifest["Options"], manifest.value("HostInputs", json::object()))};
+    bool outdated{expected.is_object() && expected != recorded};
+    auto state{modified ? State::Modified : outdated ? State::Outdated : State::Current};
+    if ((state == State::Outdated && scanOptions.Upgrade) ||
+        (state == State::Modified && scanOptions.Force)) {
+        auto options{Generator::optionsFromJson(manifest["Options"])};
+        options.WorkspacePath = workspace.string();
+        Generator generator(options);
+        generator.saveManifest(dotVscode, generator.generateConfigs(dotVscode));
+        LOG_INF("已更新 ", workspace);
+        return State::Current;
+    }
+    return state;
+}
+
+}  // namespace
+
+int scanCommand(int argc, char** argv) {
+    std::string root;
+    ScanOptions scanOptions;
+    unsigned jobs;
+    // clang-format off
+    po::options_description desc("scan Options", 79);
+    desc.add_options()
+        ("root", po::value(&root)->default_value("."), "查找工作区的根文件夹")
+        ("upgrade,u", po::bool_switch(&scanOptions.Upgrade), "重新生成过时的配置")
+        ("force,f", po::bool_switch(&scanOptions.Force), "同时重新生成被修改过的配置")
+        ("all,a", po::bool_switch(&scanOptions.All), "同时列出最新的工作区")
+        ("jobs,j", po::value(&jobs)->default_value(std::max(1u, std::thread::hardware_concurrency())), "同时扫描的线程数")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::positional_options_description pos;
+    pos.add("root", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pos).run(), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << "用法：vscch3 scan [<root>] [options]" << std::endl;
+        desc.print(std::cout, 30);
+        return 0;
+    }
+    if (!fs::is_directory(root)) {
+        LOG_ERR(root, " 不是文件夹。");
+        return 1;
+    }
+
+    Renderer renderer;
+    std::mutex outputMutex;
+    std::atomic_size_t counts[static_cast<int>(State::Count)]{};
+    Walker().run(root, std::max(jobs, 1u), [&](const fs::path& workspace) {
+        State state;
+        try {
+            state = check(workspace, scanOptions, renderer);
+        } catch (const std::exception& e) {
+            LOG_WRN("检查 ", workspace, " 时发生错误：", e.what());
+            state = State::Broken;
+        }
+        if (state == State::Count) return;
+        counts[static_cast<int>(state)]++;
+        if (state != State::Current || scanOptions.All) {
+            std::lock_guard lock(outputMutex);
+            std::cout << "[" << stateText[static_cast<int>(state)] << "] " << workspace.string()
+                      << std::endl;
+        }
+    });
+    std::cout << "共 ";
+    for (int i{0}; i < static_cast<int>(State::Count); i++) {
+        std::cout << (i ? "，" : "") << stateText[i] << " " << counts[i];
+    }
+    std::cout << "。" << std::endl;
+    return 0;
+}
+
+}  // namespace Scan
@@ -34,6 +34,8 @@
 
 #ifdef WINDOWS
 
+#include "assets.h"
+
 namespace fs = boost::filesystem;
 using namespace std::literals;
 
@@ -140,8 +142,38 @@ void Server::setHandlers() {
     //     res.set_content("Hello, " + name + "!", "text/plain");
     // });
 
-    server.Get("/.*", [](const Request& req, Response& res) {
-        res.set_content("Hello from cpp-httplib", "text/plain");
+    // Embedded GUI pages. They change only with the binary, so clients revalidate with ETag.
+    server.Get("/(.*)", [](const Request& req, Response& res) {
+        auto path{"/" + req.matches[1].str()};
+        if (path == "/") path = "/config.html";
+        auto asset{std::find_if(std::begin(Embed::ASSETS), std::end(Embed::ASSETS),
+                                [&](const Embed::Asset& a) { return path == a.Path; })};
+        if (asset == std::end(Embed::ASSETS)) {
+            res.status = 404;
+            return;
+        }
+        res.set_header("ETag", asset->ETag);
+        res.set_header("Cache-Control", "no-cache");
+        if (req.get_header_value("If-None-Match") == asset->ETag) {
+            res.status = 304;
+            return;
+        }
+        if (asset->Gzipped) {
+            // Every browser accepts gzip; there is no uncompressed copy to fall back to
+            if (req.get_header_value("Accept-Encoding").find("gzip") == std::string::npos) {
+                res.status = 406;
+                return;
+            }
+            res.set_header("Content-Encoding", "gzip");
+            res.set_header("Vary", "Accept-Encoding");
+        }
+        // Write directly from the embedded array
+        res.set_content_provider(
+            asset->Size, asset->ContentType,
+            [data{reinterpret_cast<const char*>(asset->Data)}](std::size_t offset, std::size_t length,
+                                                               httplib::DataSink& sink) {
+                return sink.write(data + offset, length);
+            });
     });
 }
 
@@ -166,7 +198,10 @@ void Server::startListen() {
 void Server::runGui(const Environment& env) {
     Server s(env);
     LOG_INF("本地服务器已启动，即将开始监听 ", s.port, " 端口...");
-    auto openAddress{Cli::options.GuiAddress + "?port=" + std::to_string(s.port)};
+    auto openAddress{Cli::options.GuiAddress.empty()
+                         ? "http://localhost:" + std::to_string(s.port) + "/config.html"
+                         : Cli::options.GuiAddress};
+    openAddress += "?port=" + std::to_string(s.port);
     if (!Cli::options.NoOpenBrowser) {
         LOG_WRN("已打开网页 ", openAddress, "，请在浏览器中继续操作。请不要关闭此窗口。");
         std::system(("START " + openAddress).c_str());
@@ -0,0 +1,163 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "workspace.h"
+
+#include <algorithm>
+#include <boost/assign.hpp>
+#include <boost/program_options.hpp>
+#include <ctime>
+#include <iostream>
+
+#include "log.h"
+
+namespace Workspace {
+
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+using json = nlohmann::json;
+using namespace boost::assign;
+using namespace std::literals;
+
+std::vector<std::string> listSources(const fs::path& root,
+                                     const std::vector<std::string>& extensions) {
+    auto cache(json::object());
+    return listSources(root, extensions, cache);
+}
+
+std::vector<std::string> listSources(const fs::path& root,
+                                     const std::vector<std::string>& extensions, json& cache) {
+    const auto& oldDirs{cache["dirs"]};
+    auto newDirs(json::object());
+    std::vector<std::string> result;
+    std::vector<std::string> pending{""};
+    auto now{std::time(nullptr)};
+    while (!pending.empty()) {
+        auto rel{std::move(pending.back())};
+        pending.pop_back();
+        auto dir{rel.empty() ? root : root / rel};
+        boost::system::error_code ec;
+        auto mtime{fs::last_write_time(dir, ec)};
+        if (ec) continue;
+        json entry;
+        if (auto it{oldDirs.find(rel)}; it != oldDirs.end() && it->at("mtime") == mtime) {
+            entry = *it;
+        } else {
+            // A folder changed in the same second as listing may change again unnoticed, so do not
+            // trust the timestamp next time
+            entry = json::object({{"mtime", now - mtime < 2 ? -1 : mtime},
+                                  {"files", json::array()},
+                                  {"dirs", json::array()}});
+            for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+                const auto& path{it->path()};
+                auto filename{path.filename().string()};
+                // Do not follow symlinks to folders, they may form loops
+                if (it->symlink_status().type() == fs::directory_file) {
+                    if (!filename.starts_with(".") && !(rel.empty() && filename == BUILD_DIR)) {
+                        entry["dirs"].push_back(filename);
+                    }
+                } else if (std::find(extensions.begin(), extensions.end(),
+                                     path.extension().string()) != extensions.end()) {
+                    entry["files"].push_back(filename);
+                }
+            }
+        }
+        auto prefix{rel.empty() ? ""s : rel + "/"};
+        for (auto&& file : entry["files"]) {
+            result.push_back(prefix + file.get<std::string>());
+        }
+        for (auto&& sub : entry["dirs"]) {
+            pending.push_back(prefix + sub.get<std::string>());
+        }
+        newDirs[rel] = std::move(entry);
+    }
+    // Removed folders are dropped here
+    cache["dirs"] = std::move(newDirs);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool updateCompileCommands(const fs::path& root) {
+    auto dotVscode{root / ".vscode"};
+    auto cachePath{dotVscode / COMPILE_COMMANDS_CACHE};
+    auto outputPath{dotVscode / COMPILE_COMMANDS};
+    std::string content;
+    fs::load_string_file(cachePath, content);
+    auto cache(json::parse(content));
+    auto arguments{cache.at("arguments").get<std::vector<std::string>>()};
+    auto extensions{cache.at("extensions").get<std::vector<std::string>>()};
+    auto directory{fs::absolute(root).lexically_normal().generic_string()};
+
+    auto sources{listSources(root, extensions, cache)};
+    auto commands(json::array());
+    for (auto&& source : sources) {
+        auto args{arguments};
+        args += "-c", source, "-o", BUILD_DIR + "/obj/"s + source + ".o";
+        commands += json::object({{"directory", directory}, {"file", source}, {"arguments", args}});
+    }
+    fs::save_string_file(cachePath, cache.dump());
+
+    auto result{commands.dump(2)};
+    std::string original;
+    if (fs::exists(outputPath)) {
+        fs::load_string_file(outputPath, original);
+    }
+    // Rewriting an unchanged file makes cpptools parse everything again
+    if (original == result) {
+        LOG_INF(outputPath, " 无需更新。");
+        return false;
+    }
+    fs::save_string_file(outputPath, result);
+    LOG_INF("更新了 ", outputPath, "，共 ", sources.size(), " 个源文件。");
+    return true;
+}
+
+int compdbCommand(int argc, char** argv) {
+    std::string workspace;
+    // clang-format off
+    po::options_description desc("compdb Options", 79);
+    desc.add_options()
+        ("workspace-path,w", po::value(&workspace)->default_value("."), "工作区文件夹路径")
+        ("help,h", "显示此帮助信息并退出")
+    ;
+    // clang-format on
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    } catch (const std::exception& e) {
+        LOG_ERR("命令行参数存在错误：", e.what());
+        return 1;
+    }
+    if (vm.count("help")) {
+        desc.print(std::cout, 30);
+        return 0;
+    }
+    if (!fs::exists(fs::path(workspace) / ".vscode" / COMPILE_COMMANDS_CACHE)) {
+        LOG_ERR("工作区 ", workspace, " 未配置 compile_commands.json 生成。");
+        return 1;
+    }
+    try {
+        updateCompileCommands(workspace);
+    } catch (const std::exception& e) {
+        LOG_ERR("更新 compile_commands.json 时发生错误：", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace Workspace
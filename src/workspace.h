@@ -0,0 +1,52 @@
+// Copyright (C) 2021 Guyutongxue
+//
+// This file is part of VS Code Config Helper.
+//
+// VS Code Config Helper is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// VS Code Config Helper is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with VS Code Config Helper.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace Workspace {
+
+// Folder (relative to workspace) where project build puts its outputs
+constexpr const char BUILD_DIR[]{"build"};
+
+constexpr const char COMPILE_COMMANDS[]{"compile_commands.json"};
+// Compile arguments and folder listing used by incremental update of compile_commands.json
+constexpr const char COMPILE_COMMANDS_CACHE[]{"compile_commands.cache.json"};
+
+// Find source files with given extensions (".cpp", ...) in the workspace. Hidden folders and the
+// build folder are skipped. Returned paths are relative to `root`, with '/' as separator, sorted.
+std::vector<std::string> listSources(const boost::filesystem::path& root,
+                                     const std::vector<std::string>& extensions);
+
+// Same as above, but `cache` remembers the content of each folder along with its modification
+// time, so that only changed folders are listed again. `cache` is updated in place.
+std::vector<std::string> listSources(const boost::filesystem::path& root,
+                                     const std::vector<std::string>& extensions,
+                                     nlohmann::json& cache);
+
+// Update .vscode/compile_commands.json of workspace `root` from the cache file written by
+// Generator. Returns whether the file content changed.
+bool updateCompileCommands(const boost::filesystem::path& root);
+
+// Subcommand `compdb`
+int compdbCommand(int argc, char** argv);
+
+}  // namespace Workspace
@@ -2,6 +2,21 @@ set_xmakever("2.6.3")
 
 add_rules("mode.debug", "mode.minsizerel")
 
+-- Fast-start variant: a small built-in logger instead of Boost.Log, dead code stripped
+option("lean")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the lean fast-start variant (no Boost.Log)")
+option_end()
+
+-- HTTPS through OpenSSL, needed by the update check and by toolchain mirrors. Without it, both
+-- only work over plain HTTP.
+option("tls")
+    set_default(true)
+    set_showmenu(true)
+    set_description("Support HTTPS (update check, toolchain download)")
+option_end()
+
 -- Boost.Log requires correct WINAPI version
 local BOOST_FLAGS = "-D_WIN32_WINNT=0x0600 -DBOOST_USE_WINAPI_VERSION=0x0600 -DBOOST_USE_WINDOWS_H"
 add_requires("boost 1.78.0", {
@@ -9,7 +24,7 @@ add_requires("boost 1.78.0", {
         algorithm = true,
         assign = true,
         filesystem = true,
-        log = true,
+        log = not has_config("lean"),
         nowide = true,
         process = true,
         program_options = true,
@@ -17,25 +32,37 @@ add_requires("boost 1.78.0", {
     }
 })
 add_requires("cpp-httplib 0.9.2", {
-    configs = { ssl = true }
+    configs = { ssl = has_config("tls") }
 })
 add_requires("nlohmann_json 3.10.0")
+add_requires("zlib")
 
 target("vscch3")
     set_version("3.2.0")
     set_languages("cxx20")
     add_files("src/*.cpp")
-    add_packages("boost", "cpp-httplib", "nlohmann_json")
+    add_packages("boost", "cpp-httplib", "nlohmann_json", "zlib")
     set_targetdir("$(buildir)/bin")
     add_defines(
         "UNICODE",                        -- Use "Unicode" Win32 API
         "_UNICODE",
         "JSON_USE_IMPLICIT_CONVERSIONS",  -- required by nlohmann_json
-        "CPPHTTPLIB_OPENSSL_SUPPORT",     -- required by cpp-httplib
         "WIN32_LEAN_AND_MEAN"             -- required by Boost.Nowide, Boost.Process
                                           -- https://github.com/boostorg/process/issues/96
     )
     add_cxflags(BOOST_FLAGS)              -- Use same flags as building Boost
+    if has_config("lean") then
+        add_defines("VSCCH_LEAN")
+        set_optimize("smallest")
+        set_strip("all")
+        if not is_plat("windows") then
+            add_cxflags("-ffunction-sections", "-fdata-sections")
+            add_ldflags(is_plat("macosx") and "-Wl,-dead_strip" or "-Wl,--gc-sections")
+        end
+    end
+    if has_config("tls") then
+        add_defines("CPPHTTPLIB_OPENSSL_SUPPORT")  -- required by cpp-httplib
+    end
     if is_plat("windows") then
         add_files("configs/resource.rc")
         -- https://github.com/xmake-io/xmake/issues/2008
@@ -51,7 +78,6 @@ target("vscch3")
     end
     
     -- Set config file
-    set_configvar("DEFAULT_GUI_ADDRESS", "https://v3.vscch.tk/config.html")
     on_load(function (target)
         -- https://github.com/xmake-io/xmake/discussions/2006#discussioncomment-2034133
         function set_from_file(var, source)
@@ -64,18 +90,111 @@ target("vscch3")
         end
         set_from_file("CHECK_ASCII_SRC", "scripts/check-ascii.ps1")
         set_from_file("PAUSE_CONSOLE_LAUNCHER_SRC", "scripts/pause-console-launcher.sh")
+        -- `vscch run` pauses the console on Linux and macOS
         if is_plat("windows") then
             set_from_file("PAUSE_CONSOLE_SRC", "scripts/pause-console.ps1")
-        elseif is_plat("macosx") then 
-            set_from_file("PAUSE_CONSOLE_SRC", "scripts/pause-console.rb")
-        else 
-            set_from_file("PAUSE_CONSOLE_SRC", "scripts/pause-console.sh")
         end
     end)
     set_configdir("$(buildir)/include")
     add_includedirs("$(buildir)/include")
     add_configfiles("configs/config.h.in", { pattern = "@(.-)@" })
 
+    -- Embed GUI pages (served by the local server) as gzip-compressed byte arrays. Third-party
+    -- scripts, styles and fonts are embedded too, so that the page works offline; they are
+    -- downloaded once into $(buildir)/vendor (put the files there by hand on offline machines).
+    before_build(function (target)
+        if not target:is_plat("windows") then
+            return
+        end
+        import("lib.detect.find_tool")
+        import("net.http")
+        local gzip = find_tool("gzip")
+        -- URL in config.html, path served locally, content type
+        local vendor = {
+            { "https://unpkg.com/@mdi/font@4.9.95/css/materialdesignicons.min.css", "/vendor/mdi/css/materialdesignicons.min.css", "text/css; charset=utf-8" },
+            { "https://unpkg.com/@mdi/font@4.9.95/fonts/materialdesignicons-webfont.woff2", "/vendor/mdi/fonts/materialdesignicons-webfont.woff2", "font/woff2" },
+            { "https://unpkg.com/@mdi/font@4.9.95/fonts/materialdesignicons-webfont.woff", "/vendor/mdi/fonts/materialdesignicons-webfont.woff", "font/woff" },
+            { "https://unpkg.com/vuetify@2.6.0/dist/vuetify.min.css", "/vendor/vuetify.min.css", "text/css; charset=utf-8" },
+            { "https://unpkg.com/vue@2.6.14/dist/vue.js", "/vendor/vue.js", "text/javascript; charset=utf-8" },
+            { "https://unpkg.com/rxjs@6.6.7/bundles/rxjs.umd.js", "/vendor/rxjs.umd.js", "text/javascript; charset=utf-8" },
+            { "https://unpkg.com/vue-rx@6.2.0/dist/vue-rx.js", "/vendor/vue-rx.js", "text/javascript; charset=utf-8" },
+            { "https://unpkg.com/vuetify@2.6.0/dist/vuetify.js", "/vendor/vuetify.js", "text/javascript; charset=utf-8" },
+            { "https://unpkg.com/compare-versions@3.6.0/index.js", "/vendor/compare-versions.js", "text/javascript; charset=utf-8" },
+        }
+        -- Source file, path served locally, content type
+        local assets = {
+            { "docs/config.html", "/config.html", "text/html; charset=utf-8" },
+            { "docs/config.js", "/config.js", "text/javascript; charset=utf-8" },
+            { "docs/mingw.json", "/mingw.json", "application/json" },
+            { "docs/assets/icon.ico", "/assets/icon.ico", "image/x-icon" },
+        }
+        local html = io.readfile("docs/config.html")
+        for _, item in ipairs(vendor) do
+            local file = path.join(vformat("$(buildir)/vendor"), item[2])
+            if not os.isfile(file) then
+                print("downloading %s", item[1])
+                http.download(item[1], file)
+            end
+            assert(os.isfile(file), "cannot download " .. item[1] .. ", put it at " .. file)
+            table.insert(assets, { file, item[2], item[3] })
+            html = html:replace(item[1], item[2], { plain = true })
+        end
+        -- The published page keeps the CDN links; the embedded one uses the local copies
+        local localHtml = vformat("$(buildir)/vendor/config.html")
+        io.writefile(localHtml, html)
+        assets[1][1] = localHtml
+
+        local lines = { "#pragma once", "", "#include <cstddef>", "", "namespace Embed {", "" }
+        local entries = {}
+        for i, asset in ipairs(assets) do
+            local source = asset[1]
+            local data = source
+            -- Fonts are already compressed
+            local compress = gzip and not asset[3]:startswith("font/")
+            if compress then
+                data = os.tmpfile() .. ".gz"
+                os.execv(gzip.program, { "-9", "-n", "-c", source }, { stdout = data })
+            end
+            local content = io.readfile(data, { encoding = "binary" })
+            if data ~= source then
+                os.rm(data)
+            end
+            local bytes = {}
+            for j = 1, #content do
+                bytes[j] = string.format("0x%02x,", content:byte(j))
+                if j % 16 == 0 then
+                    bytes[j] = bytes[j] .. "\n"
+                end
+            end
+            table.insert(lines, "constexpr const unsigned char ASSET_" .. i .. "[]{")
+            table.insert(lines, table.concat(bytes))
+            table.insert(lines, "};")
+            table.insert(entries, string.format('    {"%s", "%s", ASSET_%d, sizeof(ASSET_%d), "\\"%s\\"", %s},',
+                asset[2], asset[3], i, i, hash.sha256(source):sub(1, 16), compress and "true" or "false"))
+        end
+        table.insert(lines, "")
+        table.insert(lines, "struct Asset {")
+        table.insert(lines, "    const char* Path;")
+        table.insert(lines, "    const char* ContentType;")
+        table.insert(lines, "    const unsigned char* Data;")
+        table.insert(lines, "    std::size_t Size;")
+        table.insert(lines, "    const char* ETag;")
+        table.insert(lines, "    bool Gzipped;")
+        table.insert(lines, "};")
+        table.insert(lines, "")
+        table.insert(lines, "constexpr const Asset ASSETS[]{")
+        table.join2(lines, entries)
+        table.insert(lines, "};")
+        table.insert(lines, "")
+        table.insert(lines, "}")
+        local output = vformat("$(buildir)/include/assets.h")
+        local text = table.concat(lines, "\n") .. "\n"
+        -- Keep the timestamp, so that the server is not recompiled every time
+        if not os.isfile(output) or io.readfile(output) ~= text then
+            io.writefile(output, text)
+        end
+    end)
+
     -- Create 7z archive
     on_package(function (target)
         os.rm("$(buildir)/package")
@@ -87,3 +206,52 @@ target("vscch3")
         )
     end)
 target_end()
+
+-- Build the variants and compare them. This reconfigures the project, so run `xmake f` again
+-- afterwards.
+task("compare-lean")
+    set_menu {
+        usage = "xmake compare-lean [options]",
+        description = "Compare binary size, startup page faults and --version latency of full and lean builds",
+        options = {
+            {'n', "runs", "kv", "200", "Number of --version runs to average"}
+        }
+    }
+    on_run(function ()
+        import("core.base.option")
+        import("lib.detect.find_program")
+        local runs = tonumber(option.get("runs"))
+        local time = find_program("time", { paths = { "/usr/bin" }, check = "--version" })
+        local rows = {}
+        local variants = {
+            { "full", "--lean=n", "--tls=y" },
+            { "lean", "--lean=y", "--tls=y" },
+            { "lean-notls", "--lean=y", "--tls=n" },
+        }
+        for _, v in ipairs(variants) do
+            local variant = v[1]
+            local buildir = path.join("build", "compare-" .. variant)
+            os.execv("xmake", { "f", "-y", "-m", "minsizerel", v[2], v[3], "-o", buildir })
+            os.execv("xmake", { "build", "vscch3" })
+            local binary = os.files(path.join(buildir, "bin", is_host("windows") and "*.exe" or "*"))[1]
+            -- Warm up the page cache
+            os.iorunv(binary, { "--version" })
+            local faults = "n/a"
+            if time then
+                local _, err = os.iorunv(time, { "-f", "%R", binary, "--version" })
+                local lines = err:trim():split("\n")
+                faults = lines[#lines] or faults
+            end
+            local start = os.mclock()
+            for i = 1, runs do
+                os.iorunv(binary, { "--version" })
+            end
+            local latency = (os.mclock() - start) / runs
+            table.insert(rows, { variant, os.filesize(binary), faults, latency })
+        end
+        print(string.format("%-10s %12s %14s %16s", "build", "size (bytes)", "minor faults", "--version (ms)"))
+        for _, row in ipairs(rows) do
+            print(string.format("%-10s %12d %14s %16.2f", row[1], row[2], row[3], row[4]))
+        end
+    end)
+task_end()